@@ -0,0 +1,257 @@
+#ifndef __ADAPTIVE_BARRIER_HPP_IS_INCLUDED__
+#define __ADAPTIVE_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <utility>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+#include "memory_order_policy.hpp"
+#include "prefetch_layout_policy.hpp"
+#include "completion_function.hpp"
+#include "tsc.hpp"
+#include "centralized_sense_reversing_barrier.hpp"
+#include "static_tree_barrier_global_departure.hpp"
+#include "logical_id_static_tree_barrier.hpp"
+
+namespace barrier{
+
+	/**
+	 * Adaptive Barrier:
+	 * ----------------
+	 *
+	 * No algorithm wins everywhere: the centralized barrier wins with few threads and the static tree with global departure with many, and where the line
+	 * falls depends on the machine and on the imbalance of the workload. This barrier has one of each and switches between them at runtime, by the cost it
+	 * measures:
+	 *	(1) Sampling: one phase every sample_period is sampled. In a sampled phase each thread reads the time stamp counter (tsc.hpp) before its arrival
+	 *	and after its departure, into a slot of its own. The cost of the phase is the time from the last arrival to the last departure (what the barrier
+	 *	adds to the slowest thread) and the skew is the time from the first arrival to the last one (the imbalance of the workload).
+	 *	(2) Evaluation: the departures of a sampled phase are only known once the threads have arrived at the next phase, thus the samples are evaluated by
+	 *	the completion step of the next phase (sample_period must be at least 2, so that the next phase does not overwrite them).
+	 *	(3) Decision: every window samples of the current algorithm the mean cost and skew of the window become its estimate, and the barrier switches to
+	 *	the other algorithm if that one is estimated to be faster by more than 1/8 (the hysteresis). The estimate of the other algorithm gets stale, since
+	 *	the workload changes: when it has never been measured, when it is older than refresh_windows windows or when the skew (a moving average across the
+	 *	windows) has since changed by more than 2x and by more than half the cost of the barrier, the barrier switches to the other algorithm for a window
+	 *	to measure it again (and switches back at the end of that window if it is slower). The skews of a balanced workload are noise, smaller than the
+	 *	cost, so they do not trigger a measurement.
+	 *
+	 * The switch is safe because it is made in the completion step of the current algorithm (see completion_function.hpp): everybody has arrived and nobody
+	 * has departed, so the next algorithm to use is published by the departure, and each algorithm is left at a phase boundary (the centralized barrier is
+	 * used through its std::barrier interface, so it has no local senses to get out of step, and the nodes of the tree all flip together). The threads read
+	 * the algorithm and whether the phase is sampled from a read-mostly line, written only at the phase boundaries.
+	 *
+	 * The completion function of the client runs once per phase, after the decision, in the completion step of whichever algorithm ends the phase.
+	 *
+	 * Data packing and alignment requirements:
+	 * ---------------------------------------
+	 * The barrier must be allocated to a cache-line boundary. The sample slots are allocated by the constructor, each one a PREFETCH_GRANULARITY block.
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance to a cache-line boundary with the number of threads:
+	 *		auto barrier = new (barrier::internal::cache_aligned_alloc(sizeof(adaptive_barrier<>))) adaptive_barrier<>(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+	 */
+	template<class MemoryOrder = default_memory_order, unsigned int MaxFanIn = 8, class CompletionFunction = no_completion>
+	class adaptive_barrier : private barrier::internal::completion_holder<CompletionFunction>{
+	public:
+		using size_type = unsigned int;
+		using memory_order_policy = MemoryOrder;
+
+		enum algorithm{
+			centralized = 0,
+			tree,
+			num_algorithms
+		};
+
+	private:
+		// the completion function of both algorithms
+		struct phase_end{
+			adaptive_barrier* owner;
+
+			void operator()() const{
+				owner->complete_phase();
+			}
+		};
+
+	public:
+		using centralized_barrier_type = centralized_sense_reversing_barrier<MemoryOrder, default_prefetch_layout, phase_end>;
+		using tree_barrier_type = logical_id_static_tree_barrier<static_tree_barrier_global_departure<MemoryOrder, MaxFanIn, phase_end> >;
+
+		static const size_type refresh_windows = 16;
+
+		// Initialization is not atomic!
+		explicit adaptive_barrier(size_type n, size_type sample_period = 64, size_type window = 8, size_type fan_in = 2,
+					  CompletionFunction completion = CompletionFunction())
+			: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), centralized_barrier(n, phase_end{this}),
+			  tree_barrier(n, fan_in, 2, phase_end{this}), current{centralized}, sampling{false}, num_threads{n}, sample_period{sample_period},
+			  window{window}, phase{0}, evaluate_pending{false}, window_samples{0}, window_cost{0}, window_skew{0}, windows{0}, skew_average{0}{
+			assert(n > 0 && sample_period >= 2 && window > 0);
+
+			samples = static_cast<sample*>(barrier::internal::cache_aligned_alloc(n*sizeof(sample), PREFETCH_GRANULARITY));
+			for (size_type i = 0; i < n; ++i){
+				new (&samples[i]) sample();
+			}
+
+			for (size_type a = 0; a < num_algorithms; ++a){
+				estimate[a] = known_estimate{false, 0, 0, 0};
+			}
+		}
+
+		~adaptive_barrier(){
+			barrier::internal::cache_aligned_free(samples);
+		}
+
+		adaptive_barrier(const adaptive_barrier&) = delete;
+		adaptive_barrier& operator=(const adaptive_barrier&) = delete;
+
+		void await(size_type id){
+			assert(id < num_threads);
+
+			if (!sampling){
+				run(current, id);
+				return;
+			}
+
+			// the slot is read at the end of the next phase, published by my arrival at it
+			sample& s = samples[id];
+			s.arrival = barrier::internal::read_tsc();
+			run(current, id);
+			s.departure = barrier::internal::read_tsc();
+		}
+
+		//! The algorithm of the next phase (only meaningful between the phases)
+		algorithm current_algorithm() const{
+			return current;
+		}
+
+		//! The last estimated cost of the given algorithm in time stamp counter units, 0 if it has not been measured
+		std::uint64_t estimated_cost(algorithm a) const{
+			return estimate[a].cost;
+		}
+
+	private:
+		void run(algorithm a, size_type id){
+			if (a == centralized){
+				centralized_barrier.arrive_and_wait();
+			}
+			else{
+				tree_barrier.await(id);
+			}
+		}
+
+		// run by the last thread to arrive, before anybody departs
+		void complete_phase(){
+			if (evaluate_pending){
+				evaluate_pending = false;
+				evaluate();
+			}
+
+			if (sampling){
+				// the departures of this phase are written after it ends
+				evaluate_pending = true;
+			}
+
+			phase = (phase + 1) % sample_period;
+			sampling = (phase == 0);
+
+			this->run_completion();
+		}
+
+		void evaluate(){
+			std::uint64_t first_arrival = std::numeric_limits<std::uint64_t>::max(), last_arrival = 0, last_departure = 0;
+
+			for (size_type i = 0; i < num_threads; ++i){
+				first_arrival = std::min(first_arrival, samples[i].arrival);
+				last_arrival = std::max(last_arrival, samples[i].arrival);
+				last_departure = std::max(last_departure, samples[i].departure);
+			}
+
+			window_cost += (last_departure > last_arrival) ? last_departure - last_arrival : 0;
+			window_skew += last_arrival - first_arrival;
+
+			if (++window_samples == window){
+				decide();
+			}
+		}
+
+		void decide(){
+			const algorithm other = (current == centralized) ? tree : centralized;
+			known_estimate& mine = estimate[current];
+			const known_estimate& theirs = estimate[other];
+
+			// the skew is a property of the workload, not of the algorithm: smooth it across the windows of both (weight 1/4)
+			const std::uint64_t mean_skew = window_skew/window;
+			skew_average = (windows == 0) ? mean_skew : skew_average - skew_average/4 + mean_skew/4;
+
+			++windows;
+			mine = known_estimate{true, window_cost/window, skew_average, windows};
+			window_samples = 0;
+			window_cost = 0;
+			window_skew = 0;
+
+			const bool stale = !theirs.valid || windows - theirs.measured_at > refresh_windows || skew_changed(mine, theirs);
+			// switch when the other one is faster by more than 1/8
+			const bool faster = theirs.cost + theirs.cost/8 < mine.cost;
+
+			if (stale || faster){
+				current = other;
+				// restart the sample period: the first phases of the other algorithm find its lines in the other caches
+				phase = 0;
+			}
+		}
+
+		// the time stamps of a thread in the last sampled phase
+		struct sample{
+			std::uint64_t arrival;
+			std::uint64_t departure;
+			char _padding[PREFETCH_GRANULARITY-2*sizeof(std::uint64_t)];
+
+			sample() : arrival{0}, departure{0} {}
+		};
+
+		struct known_estimate{
+			bool valid;
+			std::uint64_t cost; // the mean cost of the window
+			std::uint64_t skew; // the smoothed skew when it was measured
+			std::uint64_t measured_at; // the number of windows that had ended when it was measured
+		};
+
+		// whether the skew has changed enough since the other estimate to change which algorithm wins: by more than 2x, and by more than half the cost
+		// of the barrier (the skews of a balanced workload are noise that differs by far more than 2x from window to window)
+		static bool skew_changed(const known_estimate& mine, const known_estimate& theirs){
+			const std::uint64_t low = std::min(mine.skew, theirs.skew), high = std::max(mine.skew, theirs.skew);
+			const std::uint64_t floor = std::max(mine.cost, theirs.cost)/2;
+
+			return high > 2*low && high - low > floor;
+		}
+
+		alignas(CACHE_LINE_SIZE) centralized_barrier_type centralized_barrier;
+		tree_barrier_type tree_barrier;
+
+		// read by every thread at every phase, written only at the phase boundaries
+		alignas(CACHE_LINE_SIZE) algorithm current;
+		bool sampling;
+		const size_type num_threads;
+		sample* samples;
+
+		// accessed only at the phase boundaries
+		alignas(CACHE_LINE_SIZE) const size_type sample_period;
+		const size_type window;
+		size_type phase; // the phase modulo sample_period
+		bool evaluate_pending; // the last phase was sampled
+		size_type window_samples;
+		std::uint64_t window_cost;
+		std::uint64_t window_skew;
+		std::uint64_t windows; // how many windows have ended
+		std::uint64_t skew_average; // the moving average of the mean skews of the windows
+		known_estimate estimate[num_algorithms];
+	};
+
+} // namespace barrier
+
+#endif
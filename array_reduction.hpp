@@ -0,0 +1,160 @@
+#ifndef __ARRAY_REDUCTION_HPP_IS_INCLUDED__
+#define __ARRAY_REDUCTION_HPP_IS_INCLUDED__ 1
+
+#include <cstddef>
+#include <type_traits>
+#include "cache_line_size.hpp"
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace barrier{
+
+namespace internal{
+
+	// The vector instructions for the elements of type T: the vector type, its width in elements and the load, store, add, max and min of vectors.
+	// A width of 0 means there are none and the arrays are combined by the scalar loop. The instructions are chosen at compile time: AVX when compiled
+	// with -mavx (or -march=native on the i7), otherwise SSE2 which every x86-64 has. The loads and stores are unaligned so that any buffer works, but
+	// they cost nothing extra on cache-aligned buffers.
+	template<class T>
+	struct vector_ops{
+		static const std::size_t width = 0;
+	};
+
+#if defined(__AVX__)
+	template<>
+	struct vector_ops<double>{
+		using vector = __m256d;
+		static const std::size_t width = 4;
+
+		static vector load(const double* p){ return _mm256_loadu_pd(p); }
+		static void store(double* p, vector v){ _mm256_storeu_pd(p, v); }
+		static vector add(vector a, vector b){ return _mm256_add_pd(a, b); }
+		static vector max(vector a, vector b){ return _mm256_max_pd(a, b); }
+		static vector min(vector a, vector b){ return _mm256_min_pd(a, b); }
+	};
+
+	template<>
+	struct vector_ops<float>{
+		using vector = __m256;
+		static const std::size_t width = 8;
+
+		static vector load(const float* p){ return _mm256_loadu_ps(p); }
+		static void store(float* p, vector v){ _mm256_storeu_ps(p, v); }
+		static vector add(vector a, vector b){ return _mm256_add_ps(a, b); }
+		static vector max(vector a, vector b){ return _mm256_max_ps(a, b); }
+		static vector min(vector a, vector b){ return _mm256_min_ps(a, b); }
+	};
+#elif defined(__SSE2__)
+	template<>
+	struct vector_ops<double>{
+		using vector = __m128d;
+		static const std::size_t width = 2;
+
+		static vector load(const double* p){ return _mm_loadu_pd(p); }
+		static void store(double* p, vector v){ _mm_storeu_pd(p, v); }
+		static vector add(vector a, vector b){ return _mm_add_pd(a, b); }
+		static vector max(vector a, vector b){ return _mm_max_pd(a, b); }
+		static vector min(vector a, vector b){ return _mm_min_pd(a, b); }
+	};
+
+	template<>
+	struct vector_ops<float>{
+		using vector = __m128;
+		static const std::size_t width = 4;
+
+		static vector load(const float* p){ return _mm_loadu_ps(p); }
+		static void store(float* p, vector v){ _mm_storeu_ps(p, v); }
+		static vector add(vector a, vector b){ return _mm_add_ps(a, b); }
+		static vector max(vector a, vector b){ return _mm_max_ps(a, b); }
+		static vector min(vector a, vector b){ return _mm_min_ps(a, b); }
+	};
+#endif
+
+	// combines whole vectors and returns how many elements it has combined
+	template<class T, class ArrayOp>
+	std::size_t combine_vectors(T* acc, const T* in, std::size_t length, std::true_type){
+		using ops = vector_ops<T>;
+		std::size_t i = 0;
+
+		for (; i + ops::width <= length; i += ops::width){
+			ops::store(acc + i, ArrayOp::template vector<ops>(ops::load(acc + i), ops::load(in + i)));
+		}
+
+		return i;
+	}
+
+	template<class T, class ArrayOp>
+	std::size_t combine_vectors(T*, const T*, std::size_t, std::false_type){
+		return 0;
+	}
+
+	//! acc[i] = op(acc[i], in[i]) for i in [0,length) with the vector instructions, if any, and the scalar loop for the rest
+	template<class T, class ArrayOp>
+	void combine_arrays(T* acc, const T* in, std::size_t length){
+		std::size_t i = combine_vectors<T, ArrayOp>(acc, in, length, std::integral_constant<bool, (vector_ops<T>::width != 0)>());
+
+		for (; i < length; ++i){
+			acc[i] = ArrayOp::scalar(acc[i], in[i]);
+		}
+	}
+
+	// The buffers of the array reduction in a node of a tree barrier: two cache-aligned buffers of Size bytes, used by the even and the odd episodes of the
+	// node, so that the result of an episode is not overwritten by the next one. With Size 0 (no array reduction) it is empty, and the node that derives
+	// from it keeps its size.
+	template<std::size_t Size>
+	struct alignas(CACHE_LINE_SIZE) array_reduction_buffers{
+		static const std::size_t reduction_capacity = Size;
+
+		template<class T>
+		T* reduction_buffer(bool parity){
+			return reinterpret_cast<T*>(reduction_buffers[parity]);
+		}
+
+	private:
+		unsigned char reduction_buffers[2][(Size + CACHE_LINE_SIZE - 1)/CACHE_LINE_SIZE*CACHE_LINE_SIZE];
+	};
+
+	template<>
+	struct array_reduction_buffers<0>{
+		static const std::size_t reduction_capacity = 0;
+	};
+
+} // namespace internal
+
+	/**
+	 * Array Reduction Operators:
+	 * -------------------------
+	 *
+	 * The operators for the array reducing await() of static_tree_barrier, which combines the arrays of the threads element by element. Each one has a scalar()
+	 * version for any element type and a vector() version used with the vector instructions of internal::vector_ops (double and float).
+	 * Other operators can be written the same way, they need the vector() version only for element types that have vector_ops.
+	 */
+
+	template<class T>
+	struct array_sum{
+		static T scalar(T a, T b){ return a + b; }
+
+		template<class Ops>
+		static typename Ops::vector vector(typename Ops::vector a, typename Ops::vector b){ return Ops::add(a, b); }
+	};
+
+	template<class T>
+	struct array_max{
+		static T scalar(T a, T b){ return (a > b) ? a : b; } // as maxpd
+
+		template<class Ops>
+		static typename Ops::vector vector(typename Ops::vector a, typename Ops::vector b){ return Ops::max(a, b); }
+	};
+
+	template<class T>
+	struct array_min{
+		static T scalar(T a, T b){ return (a < b) ? a : b; } // as minpd
+
+		template<class Ops>
+		static typename Ops::vector vector(typename Ops::vector a, typename Ops::vector b){ return Ops::min(a, b); }
+	};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef __CACHE_ALIGNED_ALLOC_HPP_IS_INCLUDED__
+#define __CACHE_ALIGNED_ALLOC_HPP_IS_INCLUDED__ 1
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "cache_line_size.hpp"
+
+namespace barrier{
+
+namespace internal{
+
+	/**
+	 * Allocates size bytes of storage starting at a cache-line boundary.
+	 *
+	 * \param size The number of bytes to allocate
+	 * \param alignment The boundary (a power of 2 multiple of the cache-line size) for layouts that need more than a cache-line, like PREFETCH_GRANULARITY
+	 * \return A pointer to the cache-aligned storage. Release it with cache_aligned_free()
+	 * \throw bad_alloc If the storage cannot be allocated
+	 */
+	inline void* cache_aligned_alloc(std::size_t size, std::size_t alignment = CACHE_LINE_SIZE){
+		void* p = nullptr;
+
+		if (posix_memalign(&p, alignment, size)){
+			throw std::bad_alloc();
+		}
+
+		return p;
+	}
+
+	//! Releases storage obtained with cache_aligned_alloc()
+	inline void cache_aligned_free(void* p){
+		std::free(p);
+	}
+
+} // namespace internal
+
+} // namespace barrier
+
+#endif
@@ -3,4 +3,7 @@
 
 #define CACHE_LINE_SIZE (64)
 
+// the granularity of the hardware prefetcher. The L2 Adjacent Cache Line Prefetcher of the Intel fetches cache-lines in aligned pairs.
+#define PREFETCH_GRANULARITY (2*CACHE_LINE_SIZE)
+
 #endif
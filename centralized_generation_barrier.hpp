@@ -0,0 +1,125 @@
+#ifndef __CENTRALIZED_GENERATION_BARRIER_HPP_IS_INCLUDED__
+#define __CENTRALIZED_GENERATION_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <limits>
+#include <utility>
+#include "cache_line_size.hpp"
+#include "memory_order_policy.hpp"
+#include "completion_function.hpp"
+
+namespace barrier{
+
+/**
+ * Centralized Generation Barrier:
+ * ------------------------------
+ *
+ * This is the centralized barrier with the counter and the sense packed in a single 64-bit word (state): the upper 32 bits are the generation (the number
+ * of the phases that have ended) and the lower 32 bits are the number of threads that have arrived at the current one.
+ *	(1) A thread arrives with a single fetch_add(1) on state, which also tells it the generation it has arrived at (the arrival token).
+ *	(2) The last thread to arrive (the one that finds num_threads-1 arrivals) resets the count and increments the generation with a single store, since
+ *	nobody else can change state before the departure. There is no separate reset of the counter.
+ *	(3) The other threads spin on state until the generation is not their own any more.
+ * There is no local sense and thus no participants: the generation of a thread is the token returned by arrive(). A token names a phase, so wait() works
+ * for any generation, even one that has ended long ago (it returns at once).
+ *
+ * The arrivals and the spinning threads now share the cache line of state, so each arrival invalidates the line of the spinning threads. The separate
+ * counter and sense of centralized_sense_reversing_barrier avoid that, and the benchmark compares the two.
+ *
+ * The memory orders, the completion function and the std::barrier interface (arrive_and_drop() included) are those of the centralized sense-reversing
+ * barrier.
+ *
+ * Data packing and alignment requirements:
+ * ---------------------------------------
+ *	state takes a whole cache line. num_threads is read by every arrival but written only when threads drop out, so it is kept with the drops in the next
+ *	cache line. The barrier must be allocated to a cache-line boundary (cache_aligned_alloc()).
+ *
+ * Usage:
+ * -----
+ *	Step (a): Allocate and construct the barrier to a cache-line boundary with the number of threads:
+ *		auto barrier = new (barrier::internal::cache_aligned_alloc(sizeof(centralized_generation_barrier<>))) centralized_generation_barrier<>(num_threads);
+ *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+ *	Step (c): Have the threads use the barrier through arrive_and_wait(), or arrive() and wait(token).
+ */
+template<class MemoryOrder = default_memory_order, class CompletionFunction = no_completion>
+class centralized_generation_barrier : private barrier::internal::completion_holder<CompletionFunction>{
+public:
+	using size_type = unsigned int;
+	using memory_order_policy = MemoryOrder;
+
+	// the generation a thread has arrived at
+	using arrival_token = std::uint32_t;
+
+	// Initialization is not atomic!
+	explicit centralized_generation_barrier(size_type n, CompletionFunction completion = CompletionFunction())
+		: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), state{0}, num_threads{n}, drops{0} {}
+
+	static constexpr std::ptrdiff_t max() noexcept{
+		return std::numeric_limits<size_type>::max();
+	}
+
+	// arrives on behalf of update threads and returns the generation they have arrived at
+	arrival_token arrive(std::ptrdiff_t update = 1){
+		// read the expected count before arriving, the last thread may lower it once i have arrived (see arrive_and_drop())
+		const size_type expected = num_threads;
+
+		const std::uint64_t pre_state = state.fetch_add(static_cast<std::uint64_t>(update), MemoryOrder::arrive);
+		const arrival_token generation = static_cast<arrival_token>(pre_state >> count_bits);
+		const size_type pre_arrived = static_cast<size_type>(pre_state & count_mask);
+		assert(update > 0 && pre_arrived + update <= expected);
+
+		if (pre_arrived + update == expected){
+			// i am the last to arrive
+			// but first sync memory
+			MemoryOrder::acquire(state);
+
+			const size_type dropped = drops.load(std::memory_order_relaxed);
+			if (dropped != 0){
+				drops.store(0, std::memory_order_relaxed);
+				num_threads -= dropped;
+			}
+
+			// run the serial section of the phase before anybody departs
+			this->run_completion();
+			// reset the count and start the next generation
+			state.store(static_cast<std::uint64_t>(generation + 1) << count_bits, MemoryOrder::signal);
+		}
+
+		return generation;
+	}
+
+	// waits until the given generation has ended (returns at once for the last thread and for the generations that have ended before)
+	void wait(arrival_token generation) const{
+		// the difference keeps working when the generation wraps around
+		while (static_cast<std::int32_t>(static_cast<arrival_token>(state.load(MemoryOrder::spin) >> count_bits) - generation) <= 0){}
+		MemoryOrder::acquire(state); // sync memory
+	}
+
+	void arrive_and_wait(){
+		wait(arrive());
+	}
+
+	// arrives at the current phase and lowers the expected count of the following phases by one (see centralized_sense_reversing_barrier)
+	void arrive_and_drop(){
+		drops.fetch_add(1, std::memory_order_relaxed); // published by the arrival
+		arrive();
+	}
+
+private:
+	static const unsigned int count_bits = 32;
+	static const std::uint64_t count_mask = (std::uint64_t(1) << count_bits) - 1;
+
+	std::atomic<std::uint64_t> state; // the generation (upper half) and the number of threads that have arrived at it (lower half)
+	char false_sharing_state_padding[CACHE_LINE_SIZE - sizeof(state)];
+
+	size_type num_threads; // how many threads are expected to arrive at the barrier? Lowered only by the last thread
+	std::atomic<size_type> drops; // how many threads have dropped out in this phase
+	char align_padding[CACHE_LINE_SIZE - sizeof(num_threads) - sizeof(drops)];
+};
+
+} // namespace barrier
+
+#endif
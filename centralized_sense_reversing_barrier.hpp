@@ -1,9 +1,16 @@
 #ifndef __CENTRALIZED_SENSE_REVERSING_BARRIER_HPP_IS_INCLUDED__
 #define __CENTRALIZED_SENSE_REVERSING_BARRIER_HPP_IS_INCLUDED__ 1
 
+#include <cassert>
+#include <cstddef>
 #include <atomic>
+#include <limits>
+#include <utility>
 #include "cache_line_size.hpp"
 #include "atomic_backoff.hpp"
+#include "memory_order_policy.hpp"
+#include "prefetch_layout_policy.hpp"
+#include "completion_function.hpp"
 
 namespace barrier{
 
@@ -18,18 +25,33 @@ namespace barrier{
  *	In this case, that thread is responsible for signalling the other threads that they can proceed to the next phase.
  *	(3) sense: a shared atomic boolean flag initialized to true and switching values at the end of each barrier phase. The last thread to arrive changes the
  *	value of the sense variable. The other threads continuously monitor that value and when it changes value they know that they can proceed to the next phase.
- *	(4) local_sense: a thread local variable that each thread uses to keep monitoring of sense changes.
+ *	(4) local_sense: a per-thread variable that each thread uses to keep monitoring of sense changes. It is kept in a participant object that the client
+ *	allocates for each (thread, barrier) pair and passes to await(). Since the local sense belongs to the barrier instance and not to the thread, one thread can
+ *	use many barrier instances with different phase histories, and there is no thread local storage access in await().
+ *
+ * Memory ordering:
+ * ---------------
+ *	The memory orders used by await() are given by the MemoryOrder policy (see memory_order_policy.hpp), so that the seq-cst, acq-rel and relaxed versions
+ *	can be compared in the same binary. The default is the relaxed version with the extra acquire load.
+ *
+ * Completion function:
+ * -------------------
+ *	The last thread to arrive runs the CompletionFunction given to the constructor (see completion_function.hpp) before it flips the sense, so the
+ *	serial section of a phase needs no extra barrier. The default no_completion is an empty base of the barrier: no storage and no call.
  *
  * Data packing:
  * ------------
  *	I pack members (1), (2) and (3) in "struct centralized_sense_reversing_barrier" which in some sense represents the barrier.
- *	The local sense variables must be allocated by the client and passed as parameter to the await() function by each thread.
+ *	The local sense variables (participants) must be allocated by the client and passed as parameter to the await() function by each thread.
  *
  * Alignment requirements:
  * ----------------------
  *	The struct itself avoids false-sharing internally. However, to avoid false-sharing between different instances and other data the threads may need, a 
- *	object of this struct must be allocated to cache-line boundaries.
- *	The local_sense variables must be allocated by the client and each must be allocated to cache-line boundaries to avoid false-sharing. Also, it would be beneficial
+ *	object of this struct must be allocated to cache-line boundaries (to PREFETCH_GRANULARITY boundaries with the prefetch_pair_layout).
+ *	How far apart the counter and the sense are is given by the Layout policy (see prefetch_layout_policy.hpp). The default keeps them 192 cache-lines apart,
+ *	which is more than 12KB per barrier. When many barriers are needed use the prefetch_pair_layout that only separates them by the prefetch granularity.
+ *	The participants must be allocated by the client and each must be allocated to cache-line boundaries to avoid false-sharing (the participant is padded to
+ *	a whole cache line). Also, it would be beneficial
  *	to have those cache-lines allocated to a memory module near to the thread that will use that cache-line. Also, avoid having those cache-lines allocated as an array
  *	because if hardware prefetching is enabled, it will result in false-sharing even across different cache-lines!! (This has been documented in the paper
  *	"The Scalable Commutativity Rule: Designing Scalable Software for Multicore Processors" - see the Experimental Setup section).
@@ -38,148 +60,167 @@ namespace barrier{
  * -----
  * 	This barrier is used as:
  *	
- *	Step (a): Allocate an instance of struct centralized_sense_reversing_barrier to cache-line boundary
- *		struct centralized_sense_reversing_barrier* barrier = cache_aligned_alloc(...);
+ *	Step (a): Allocate an instance of centralized_sense_reversing_barrier to cache-line boundary (or to the block_size of its layout)
+ *		void* storage = barrier::internal::cache_aligned_alloc(sizeof(centralized_sense_reversing_barrier<>));
+ *	or
+ *		void* storage = barrier::internal::cache_aligned_alloc(sizeof(centralized_sense_reversing_barrier<default_memory_order, prefetch_pair_layout>),
+ *									PREFETCH_GRANULARITY);
  *	Step (b): Initialize the barrier instance:
- *		init_centralized_sense_reversing_barrier(barrier, num_threads);
- *	Step (c): Allocate the local_sense variables for each thread (that is allocate in total num_threads local_sense variables). Follow the guidelines under the 
- *	"Alignment Requirements" section. Use the init_centralized_sense_reversing_barrier_local_sense() method to *EACH* local_sense variable.
- *	Step (d): Pass the local_sense to each thread that will use it (this need some extra bookkeeping by each thread). 
+ *		auto barrier = new (storage) centralized_sense_reversing_barrier<>(num_threads);
+ *	Step (c): Allocate a participant for each thread (that is allocate in total num_threads participants) and construct it with its default constructor.
+ *	Follow the guidelines under the "Alignment Requirements" section.
+ *	Step (d): Pass the participant to each thread that will use it (this need some extra bookkeeping by each thread). 
  *	NOTE: depending on the memory binding policy steps (c) and (d) can be mixed or executed in the opposite order. For example, have each thread allocate its own
- *	local_sense.
+ *	participant.
  * 	Step (e): Since the initialization of the barrier instance is not atomic, memory visibility must be ensured for that threads. This can be done with a simple flag
  *	where the thread that performed the initialization sets to true with a release memory ordering and each thread waits with acquire memory ordering.
- *	Step (f): Have the threads use the barrier instance through the await() method.
+ *	Step (f): Have the threads use the barrier instance through the await(participant) method.
+ *	Alternatively, a thread can use the split-phase (fuzzy) version: arrive() signals the arrival and returns a token, and wait(token) waits for the departure.
+ *	The thread can do work that does not depend on the other threads in between, hiding the latency of the barrier.
+ *	The barrier also has the interface of std::barrier (arrive_and_wait(), arrive(update), wait(token), arrive_and_drop()) that needs no participants.
  */ 
-class centralized_sense_reversing_barrier{
+template<class MemoryOrder = default_memory_order, class Layout = default_prefetch_layout, class CompletionFunction = no_completion>
+class centralized_sense_reversing_barrier : private barrier::internal::completion_holder<CompletionFunction>{
 public:
 	using size_type = unsigned int;
+	using memory_order_policy = MemoryOrder;
+	using layout_policy = Layout;
+
+	static_assert(Layout::hot_field_distance % CACHE_LINE_SIZE == 0 && Layout::block_size % CACHE_LINE_SIZE == 0,
+			"the layout must keep the hot fields in different cache-lines");
+
+	// the local sense of a thread for this barrier. Must be allocated in cache-line boundaries.
+	struct participant{
+		bool local_sense;
+		char _local_sense_padding[CACHE_LINE_SIZE-sizeof(local_sense)];
+
+		participant() : local_sense{false} {}
+	};
 
 	// Initialization is not atomic!
-	explicit centralized_sense_reversing_barrier(size_type n) : counter{0}, sense{true}, num_threads{n} {}
+	explicit centralized_sense_reversing_barrier(size_type n, CompletionFunction completion = CompletionFunction())
+		: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), counter{0}, drops{0}, num_threads{n}, sense{true} {}
+
+	void await(participant& p){
+		// read the expected count before arriving, the last thread may lower it once i have arrived (see arrive_and_drop())
+		const size_type expected = num_threads;
 
-	#if 1
-	void await(){
 		// arrive at the barrier
-		const size_type pre_arrived = counter.fetch_add(1, std::memory_order_release);
+		const size_type pre_arrived = counter.fetch_add(1, MemoryOrder::arrive);
 
-		if (pre_arrived + 1 == num_threads){
+		if (pre_arrived + 1 == expected){
 			// i am the last to arrive so reset and signal departure
-			// but first sync memory
-			counter.load(std::memory_order_acquire);
-			counter.store(0, std::memory_order_relaxed);
-			sense.store(local_sense, std::memory_order_release);
+			complete_phase(p.local_sense);
 		}
 		else{
 			barrier::internal::default_atomic_backoff backoff;
 
 			// wait until the last one arrives
-			while (sense.load(std::memory_order_relaxed) != local_sense){
+			while (sense.load(MemoryOrder::spin) != p.local_sense){
 				//backoff();				
 			}
-			sense.load(std::memory_order_acquire); // sync memory
+			MemoryOrder::acquire(sense); // sync memory
 		}
 
-		local_sense = !local_sense;
+		p.local_sense = !p.local_sense;
 	}
-	#endif
 
-	#if 0
-	void await(){
-		// the seq-cst version
+	// the sense value of the phase a thread has arrived at
+	using arrival_token = bool;
+
+	// Split-phase version of await(): arrive() signals my arrival and returns immediately (the last thread to arrive also signals departure). Then the
+	// thread can do some local work and call wait() with the returned token to wait for the departure. A thread must call wait() before arriving again.
+	arrival_token arrive(participant& p){
+		const arrival_token token = p.local_sense;
+		const size_type expected = num_threads;
 
 		// arrive at the barrier
-		const size_type pre_arrived = counter.fetch_add(1);
+		const size_type pre_arrived = counter.fetch_add(1, MemoryOrder::arrive);
 
-		if (pre_arrived + 1 == num_threads){
-			counter.store(0);
-			sense.store(local_sense);
+		if (pre_arrived + 1 == expected){
+			complete_phase(token);
 		}
-		else{
-			barrier::internal::default_atomic_backoff backoff;
 
-			// wait until the last one arrives
-			while (sense.load() != local_sense){
-				//backoff();				
-			}
-			sense.load(); // sync memory
-		}
+		p.local_sense = !p.local_sense;
 
-		local_sense = !local_sense;
+		return token;
 	}
-	#endif
-
-	#if 0
-	void await(){
-		// arrive at the barrier
-		const size_type pre_arrived = counter.fetch_add(1, std::memory_order_acq_rel);
 
-		if (pre_arrived + 1 == num_threads){
-			// i am the last to arrive so reset and signal departure
-			counter.store(0, std::memory_order_relaxed);
-			sense.store(local_sense, std::memory_order_release);
-		}
-		else{
-			barrier::internal::default_atomic_backoff backoff;
+	void wait(arrival_token token) const{
+		// wait until the last one arrives (returns immediately for the last one)
+		while (sense.load(MemoryOrder::spin) != token){}
+		MemoryOrder::acquire(sense); // sync memory
+	}
 
-			// wait until the last one arrives
-			while (sense.load(std::memory_order_acquire) != local_sense){
-				//backoff();				
-			}
-		}
+	// The std::barrier interface: the threads need no participants, so the barrier is a drop-in replacement for std::barrier<CompletionFunction>.
+	// The token is read from sense itself: the current phase cannot end before my arrival, thus the sense it will end with is !sense. This costs a load
+	// of the sense line before the arrival, which the thread has in its cache since it spun on it in the previous phase. A thread should use either the
+	// participants or this interface with one barrier instance, since its participant would miss the phases it passed through the latter.
 
-		local_sense = !local_sense;
+	static constexpr std::ptrdiff_t max() noexcept{
+		return std::numeric_limits<size_type>::max();
 	}
-	#endif
 
-	#if 0
-	void await(){
-		// version that avoids hardware prefetching
+	// arrives on behalf of update threads
+	arrival_token arrive(std::ptrdiff_t update = 1){
+		const arrival_token token = !sense.load(std::memory_order_relaxed);
+		const size_type expected = num_threads;
+
 		// arrive at the barrier
-		const size_type pre_arrived = counter.fetch_add(1, std::memory_order_release);
+		const size_type pre_arrived = counter.fetch_add(static_cast<size_type>(update), MemoryOrder::arrive);
+		assert(update > 0 && pre_arrived + update <= expected);
 
-		if (pre_arrived + 1 == num_threads){
-			// i am the last to arrive so reset and signal departure
-			// but first sync memory
-			counter.load(std::memory_order_acquire);
-			counter.store(0, std::memory_order_relaxed);
-			sense.store(local_sense, std::memory_order_release);
+		if (pre_arrived + update == expected){
+			complete_phase(token);
 		}
-		else{
-			barrier::internal::default_atomic_backoff backoff;
 
-			// wait until the last one arrives
-			while (sense.load(std::memory_order_relaxed) != local_sense){
-				//backoff();				
-			}
-			sense.load(std::memory_order_acquire); // sync memory
-		}
+		return token;
+	}
+
+	void arrive_and_wait(){
+		wait(arrive());
+	}
 
-		local_sense = !local_sense;
+	// Arrives at the current phase and lowers the expected count of the following phases by one. The last thread of the phase applies the drops
+	// before it signals departure, so the phases never see a half-updated count. The calling thread must not use the barrier again.
+	void arrive_and_drop(){
+		drops.fetch_add(1, std::memory_order_relaxed); // published by the arrival
+		arrive();
 	}
-	#endif
 
 private:
+	// the work of the last thread to arrive: reset, apply the drops, run the completion function and signal departure
+	void complete_phase(arrival_token token){
+		// but first sync memory
+		MemoryOrder::acquire(counter);
+		counter.store(0, MemoryOrder::reset);
+
+		// nobody can arrive at the next phase before the departure, so nobody reads num_threads now
+		const size_type dropped = drops.load(std::memory_order_relaxed);
+		if (dropped != 0){
+			drops.store(0, std::memory_order_relaxed);
+			num_threads -= dropped;
+		}
+
+		// run the serial section of the phase before anybody departs
+		this->run_completion();
+		sense.store(token, MemoryOrder::signal);
+	}
+
 	std::atomic<size_type> counter; // number of threads that have arrived 
+	std::atomic<size_type> drops; // how many threads have dropped out in this phase (arrive_and_drop). Rarely written, it shares the line of counter.
 	// the counter and sense variables must be cache-aligned. first i add padding to separate the counter from the sense.
-	char false_sharing_counter_padding[CACHE_LINE_SIZE - sizeof(counter)];
-	// now counter together with the padding fit in a cache-line. For that to happen the centralized_sense_reversing_barrier must start at a cache-line!
-	// under this assumption, sense begins at the second cache-line and let's put it in a whole cache-line too
 	// IMPORTANT NOTICE: modern hardware usually have hardware prefetchers. For example, the Intel has a L2 Streaming Prefetch mechanism, where automatically the hardware
 	// fetches two cache-lines. This is actually wanted because each thread after accessing the counter variable will later access the sense variable (either for a load
  	// or for a store) and we will get the sense variable sooner than requested!
-	
-	// to avoid hardware prefetching put many cache lines in between!!!
-	char _a[64*CACHE_LINE_SIZE];
-	char _b[64*CACHE_LINE_SIZE];
-	char _c[64*CACHE_LINE_SIZE];
+	// to avoid hardware prefetching the layout policy decides how far the sense is from the counter (see prefetch_layout_policy.hpp).
+	// For that to work the centralized_sense_reversing_barrier must start at a Layout::block_size boundary!
+	char false_sharing_counter_padding[Layout::hot_field_distance - sizeof(counter) - sizeof(drops)];
 
+	size_type num_threads; // how many threads are expected to arrive at the barrier? Lowered only by the last thread (see arrive_and_drop())
 	std::atomic<bool> sense; // the sense value for the current barrier phase
-	const size_type num_threads; // how many threads are expected to arrive at the barrier?
-	// A very easy addition here is to also pad num_threads because in that way this struct will consume 3 cache-lines and will be easier to align later.
-	char align_padding[CACHE_LINE_SIZE-sizeof(num_threads)];
-
-	thread_local static bool local_sense; 
+	// A very easy addition here is to also pad num_threads and sense because in that way they will consume a whole block and will be easier to align later.
+	char align_padding[Layout::block_size-sizeof(num_threads)-sizeof(sense)];
 };
 
 } // namespace barrier
@@ -0,0 +1,132 @@
+#ifndef __CENTRALIZED_SIGNAL_WAIT_BARRIER_HPP_IS_INCLUDED__
+#define __CENTRALIZED_SIGNAL_WAIT_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <atomic>
+#include <utility>
+#include "cache_line_size.hpp"
+#include "memory_order_policy.hpp"
+#include "prefetch_layout_policy.hpp"
+#include "completion_function.hpp"
+
+namespace barrier{
+
+/**
+ * Centralized Signal-Wait Barrier:
+ * -------------------------------
+ *
+ * This is the centralized sense-reversing barrier for pipelines, where some threads only signal that they have finished a stage and others only wait for
+ * the stage to finish. There are three ways to use a phase:
+ *	(1) await(participant): arrive and wait for the departure, as in centralized_sense_reversing_barrier.
+ *	(2) signal(participant): arrive and return without waiting for the departure (a producer). The participant is counted in num_threads like (1).
+ *	(3) wait(waiter): wait for the departure of a phase without arriving (a consumer). A waiter is not counted in num_threads, so any number of them
+ *	may wait for the phases.
+ *
+ * A boolean sense does not work here: a waiter that is slower than a whole phase would miss the flip and wait for the wrong one. Thus the sense is replaced
+ * by the number of the phases that have ended (phase), the last thread to arrive increments it instead of flipping it, and each participant and each waiter
+ * keeps the number of its next phase instead of a local sense. A waiter returns when phase has passed its next phase, so a slow waiter goes through the
+ * phases it has missed one by one (without waiting), and a consumer sees every stage.
+ *
+ * A signalling participant may try to arrive at a phase while the previous one has not ended yet (a producer that runs a whole phase ahead of the others).
+ * Then it waits for the previous phase to end, or the counter would mix the arrivals of the two phases. Otherwise signal() costs a fetch_add plus the
+ * load of phase, and never spins.
+ *
+ * Memory ordering, completion function, data packing and alignment requirements are those of the centralized sense-reversing barrier (phase takes the
+ * place of sense). The participants and waiters must be allocated to cache-line boundaries.
+ *
+ * Usage:
+ * -----
+ *	Step (a): Allocate and construct the barrier as in centralized_sense_reversing_barrier, with the number of the participants (not the waiters):
+ *		auto barrier = new (storage) centralized_signal_wait_barrier<>(num_producers);
+ *	Step (b): Give each producer a participant and each consumer a waiter (default constructed before the first phase, or caught up with catch_up()).
+ *	Step (c): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+ *	Step (d): Have the producers use signal(participant) (or await(participant)) and the consumers wait(waiter).
+ */
+template<class MemoryOrder = default_memory_order, class Layout = default_prefetch_layout, class CompletionFunction = no_completion>
+class centralized_signal_wait_barrier : private barrier::internal::completion_holder<CompletionFunction>{
+public:
+	using size_type = unsigned int;
+	using memory_order_policy = MemoryOrder;
+	using layout_policy = Layout;
+
+	static_assert(Layout::hot_field_distance % CACHE_LINE_SIZE == 0 && Layout::block_size % CACHE_LINE_SIZE == 0,
+			"the layout must keep the hot fields in different cache-lines");
+
+	// a thread counted in num_threads, it uses await() or signal(). Must be allocated in cache-line boundaries.
+	struct participant{
+		size_type next_phase; // the phase i arrive at next
+		char _next_phase_padding[CACHE_LINE_SIZE-sizeof(next_phase)];
+
+		participant() : next_phase{0} {}
+	};
+
+	// a thread that only waits for the phases, it uses wait(). Must be allocated in cache-line boundaries.
+	struct waiter{
+		size_type next_phase; // the phase i wait for next
+		char _next_phase_padding[CACHE_LINE_SIZE-sizeof(next_phase)];
+
+		waiter() : next_phase{0} {}
+	};
+
+	// Initialization is not atomic!
+	explicit centralized_signal_wait_barrier(size_type n, CompletionFunction completion = CompletionFunction())
+		: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), counter{0}, num_threads{n}, phase{0} {}
+
+	void await(participant& p){
+		const size_type my_phase = p.next_phase;
+
+		signal(p);
+		wait_for(my_phase);
+	}
+
+	// arrives at the next phase of the participant and returns without waiting for the departure
+	void signal(participant& p){
+		const size_type my_phase = p.next_phase++;
+
+		// i may be a whole phase ahead: wait for the previous phase to end, and see the reset of counter
+		while (phase.load(MemoryOrder::spin) != my_phase){}
+		MemoryOrder::acquire(phase); // sync memory
+
+		// arrive at the barrier
+		const size_type pre_arrived = counter.fetch_add(1, MemoryOrder::arrive);
+
+		if (pre_arrived + 1 == num_threads){
+			// i am the last to arrive so reset and signal departure
+			// but first sync memory
+			MemoryOrder::acquire(counter);
+			counter.store(0, MemoryOrder::reset);
+			// run the serial section of the phase before anybody departs
+			this->run_completion();
+			phase.store(my_phase + 1, MemoryOrder::signal);
+		}
+	}
+
+	// waits for the next phase of the waiter to end (returns at once if it has already ended)
+	void wait(waiter& w) const{
+		wait_for(w.next_phase++);
+	}
+
+	// makes the next phase of the waiter the current phase, for a waiter that starts after the first phase (or wants to skip the phases it missed)
+	void catch_up(waiter& w) const{
+		w.next_phase = phase.load(MemoryOrder::spin);
+		MemoryOrder::acquire(phase); // sync memory
+	}
+
+private:
+	void wait_for(size_type my_phase) const{
+		// the phase has ended when phase has passed it. The difference keeps working when phase wraps around.
+		while (static_cast<int>(phase.load(MemoryOrder::spin) - my_phase) <= 0){}
+		MemoryOrder::acquire(phase); // sync memory
+	}
+
+	std::atomic<size_type> counter; // number of threads that have arrived
+	// the distance of phase from the counter is given by the layout policy (see centralized_sense_reversing_barrier)
+	char false_sharing_counter_padding[Layout::hot_field_distance - sizeof(counter)];
+
+	const size_type num_threads; // how many participants are expected to arrive at the barrier (the waiters are not counted)
+	std::atomic<size_type> phase; // how many phases have ended, it takes the place of sense
+	char align_padding[Layout::block_size-sizeof(num_threads)-sizeof(phase)];
+};
+
+} // namespace barrier
+
+#endif
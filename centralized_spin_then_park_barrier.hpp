@@ -0,0 +1,179 @@
+#ifndef __CENTRALIZED_SPIN_THEN_PARK_BARRIER_HPP_IS_INCLUDED__
+#define __CENTRALIZED_SPIN_THEN_PARK_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <cstddef>
+#include <atomic>
+#include <limits>
+#include <utility>
+#include "cache_line_size.hpp"
+#include "atomic_backoff.hpp"
+#include "memory_order_policy.hpp"
+#include "futex.hpp"
+#include "completion_function.hpp"
+
+namespace barrier{
+
+/**
+ * Centralized Spin-Then-Park Barrier:
+ * ----------------------------------
+ *
+ * This is the centralized sense-reversing barrier for oversubscribed machines. When there are more threads than hardware contexts, a thread that spins on
+ * sense may be keeping the last thread from running, and pure spinning collapses. Thus here a waiting thread spins for a bounded budget (spin_budget calls
+ * of the Backoff policy, see atomic_backoff.hpp) and then parks on a Linux futex attached to the sense word.
+ *
+ * The data are those of the centralized sense-reversing barrier plus:
+ *	(5) sleepers: the number of threads that are parked (or about to park) on sense.
+ *	(6) spin_budget: how many times a thread backs off before it parks.
+ * The sense is an int (0 or 1) because a futex word must be a 32-bit int.
+ *
+ * The last thread to arrive flips sense as usual and then does a single FUTEX_WAKE only if there are sleepers, so when nobody parks the departure costs
+ * exactly what it costs in the centralized barrier. A waiting thread first registers in sleepers and then re-checks sense before it sleeps, while the
+ * last thread first flips sense and then reads sleepers. Both pairs are seq_cst, thus either the waiting thread sees the new sense or the last thread sees
+ * the sleeper (a lost wake-up is impossible). FUTEX_WAIT itself re-checks the value of sense atomically in the kernel.
+ *
+ * Data packing and alignment requirements are those of the centralized sense-reversing barrier. The sleepers counter is placed in the line of sense: it is
+ * written only when a thread parks and the last thread reads it right after writing sense, so it costs no extra miss.
+ *
+ * The last thread to arrive runs the CompletionFunction (see completion_function.hpp) before it flips sense, while the others may be parked.
+ *
+ * Usage is that of the centralized sense-reversing barrier: each thread passes its own cache-aligned participant to await(), or the threads use the
+ * std::barrier interface (arrive_and_wait(), arrive(update), wait(token), arrive_and_drop()).
+ */
+template<class Backoff = barrier::internal::default_atomic_backoff, class MemoryOrder = default_memory_order, class CompletionFunction = no_completion>
+class centralized_spin_then_park_barrier : private barrier::internal::completion_holder<CompletionFunction>{
+public:
+	using size_type = unsigned int;
+	using memory_order_policy = MemoryOrder;
+
+	static const std::size_t default_spin_budget = 1024;
+
+	// the local sense of a thread for this barrier. Must be allocated in cache-line boundaries.
+	struct participant{
+		int local_sense;
+		char _local_sense_padding[CACHE_LINE_SIZE-sizeof(local_sense)];
+
+		participant() : local_sense{0} {}
+	};
+
+	// Initialization is not atomic!
+	explicit centralized_spin_then_park_barrier(size_type n, std::size_t spin_budget = default_spin_budget,
+						    CompletionFunction completion = CompletionFunction())
+		: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), counter{0}, drops{0}, sense{1}, sleepers{0}, spin_budget{spin_budget}, num_threads{n} {}
+
+	void await(participant& p){
+		// read the expected count before arriving (see centralized_sense_reversing_barrier)
+		const size_type expected = num_threads;
+
+		// arrive at the barrier
+		const size_type pre_arrived = counter.fetch_add(1, MemoryOrder::arrive);
+
+		if (pre_arrived + 1 == expected){
+			// i am the last to arrive so reset and signal departure
+			complete_phase(p.local_sense);
+		}
+		else{
+			wait(p.local_sense);
+		}
+
+		p.local_sense = 1 - p.local_sense;
+	}
+
+	// the sense value of the phase a thread has arrived at
+	using arrival_token = int;
+
+	// spins and then parks until the phase of the token is over
+	void wait(arrival_token token) const{
+		Backoff backoff;
+
+		// spin for a while until the last one arrives
+		std::size_t tries = 0;
+
+		while (sense.load(MemoryOrder::spin) != token){
+			if (tries++ < spin_budget){
+				backoff();
+				continue;
+			}
+
+			// the budget is exhausted: park
+			sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+			while (sense.load(std::memory_order_seq_cst) != token){
+				barrier::internal::futex_wait(sense, 1 - token);
+			}
+
+			sleepers.fetch_sub(1, std::memory_order_relaxed);
+		}
+		MemoryOrder::acquire(sense); // sync memory
+	}
+
+	// The std::barrier interface, as in centralized_sense_reversing_barrier: the token is read from sense and the drops are applied by the last thread.
+
+	static constexpr std::ptrdiff_t max() noexcept{
+		return std::numeric_limits<size_type>::max();
+	}
+
+	// arrives on behalf of update threads
+	arrival_token arrive(std::ptrdiff_t update = 1){
+		const arrival_token token = 1 - sense.load(std::memory_order_relaxed);
+		const size_type expected = num_threads;
+
+		// arrive at the barrier
+		const size_type pre_arrived = counter.fetch_add(static_cast<size_type>(update), MemoryOrder::arrive);
+		assert(update > 0 && pre_arrived + update <= expected);
+
+		if (pre_arrived + update == expected){
+			complete_phase(token);
+		}
+
+		return token;
+	}
+
+	void arrive_and_wait(){
+		wait(arrive());
+	}
+
+	// arrives at the current phase and lowers the expected count of the following phases by one
+	void arrive_and_drop(){
+		drops.fetch_add(1, std::memory_order_relaxed); // published by the arrival
+		arrive();
+	}
+
+private:
+	void complete_phase(arrival_token token){
+		// but first sync memory
+		MemoryOrder::acquire(counter);
+		counter.store(0, MemoryOrder::reset);
+
+		const size_type dropped = drops.load(std::memory_order_relaxed);
+		if (dropped != 0){
+			drops.store(0, std::memory_order_relaxed);
+			num_threads -= dropped;
+		}
+
+		// run the serial section of the phase before anybody departs
+		this->run_completion();
+		sense.store(token, std::memory_order_seq_cst);
+
+		// wake up the parked threads, if any
+		if (sleepers.load(std::memory_order_seq_cst) != 0){
+			barrier::internal::futex_wake_all(sense);
+		}
+	}
+
+	std::atomic<size_type> counter; // number of threads that have arrived
+	std::atomic<size_type> drops; // how many threads have dropped out in this phase
+	char false_sharing_counter_padding[CACHE_LINE_SIZE - sizeof(counter) - sizeof(drops)];
+
+	mutable std::atomic<int> sense; // the sense value for the current barrier phase (the futex word)
+	mutable std::atomic<size_type> sleepers; // how many threads are parked on sense
+	char false_sharing_sense_padding[CACHE_LINE_SIZE - sizeof(sense) - sizeof(sleepers)];
+
+	const std::size_t spin_budget; // how many times to back off before parking
+	size_type num_threads; // how many threads are expected to arrive at the barrier? Lowered only by the last thread
+	char align_padding[CACHE_LINE_SIZE - sizeof(spin_budget) - sizeof(num_threads)];
+};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef __COMPLETION_FUNCTION_HPP_IS_INCLUDED__
+#define __COMPLETION_FUNCTION_HPP_IS_INCLUDED__ 1
+
+#include <type_traits>
+#include <utility>
+#include "cache_line_size.hpp"
+
+namespace barrier{
+
+	/**
+	 * Completion Functions:
+	 * --------------------
+	 *
+	 * As in the C++20 std::barrier, a barrier can run a completion function once per phase: after all the threads have arrived and before any of them
+	 * departs. It is run by the thread that finds out that everybody has arrived (the last arriver of the centralized barriers or the root of the tree
+	 * barriers), thus it is the place for the serial sections of the phases, like swapping buffers or advancing a timestep, without an extra barrier
+	 * around them. The completion function is called without arguments and must not throw.
+	 *
+	 * The default is no_completion which does nothing and costs nothing: it takes no storage and the call is inlined away.
+	 */
+	struct no_completion{
+		void operator()() const{}
+	};
+
+namespace internal{
+
+	// Keeps the completion function of a barrier, which derives from it. An empty function object (like no_completion or a lambda without captures) is an
+	// empty base that takes no storage. Any other one is aligned (thus padded) to whole cache lines, so that the padded layout of the barrier does not shift.
+	template<class CompletionFunction, bool = std::is_empty<CompletionFunction>::value>
+	class completion_holder : private CompletionFunction{
+	protected:
+		explicit completion_holder(CompletionFunction f) : CompletionFunction(std::move(f)){}
+
+		void run_completion(){
+			static_cast<CompletionFunction&>(*this)();
+		}
+	};
+
+	template<class CompletionFunction>
+	class alignas(CACHE_LINE_SIZE) completion_holder<CompletionFunction, false>{
+	protected:
+		explicit completion_holder(CompletionFunction f) : completion(std::move(f)){}
+
+		void run_completion(){
+			completion();
+		}
+
+	private:
+		CompletionFunction completion;
+	};
+
+} // namespace internal
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef __DISSEMINATION_BARRIER_HPP_IS_INCLUDED__
+#define __DISSEMINATION_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <vector>
+#include <atomic>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+
+namespace barrier{
+
+	/**
+	 * Dissemination Barrier:
+	 * ---------------------
+	 *
+	 * There is no shared counter and no departure stage. The barrier proceeds in ceil(log_k N) rounds where k is the radix. In round r the thread with
+	 * logical id i signals the threads (i + j*k^r) mod N for j = 1,...,k-1 and then waits for the k-1 signals coming from the threads (i - j*k^r) mod N.
+	 * After the last round each thread has (transitively) heard from every other thread and can leave. Distances j*k^r that are not less than N would
+	 * make a thread signal itself or signal the same partner twice and are skipped (on both the sending and the receiving side).
+	 *
+	 * Each thread has the following data:
+	 *	(1) Where do my partners signal me? One flag per (round, j) pair. The flags are sense-reversing, so that they never need to be re-set.
+	 *	(2) Which flags of my partners should i signal? One pointer per (round, j) pair.
+	 *	(3) Which is my local sense? bool sense
+	 *
+	 * A fast thread that has left episode e may signal its partner for episode e+1 before that partner has seen the signal for episode e. Thus as in the
+	 * version presented in the Mellor-Crummey/Scott paper i keep two sets of flags and alternate between them with a parity bit. The local sense is flipped
+	 * every second episode, when the parity wraps around.
+	 *
+	 * Data Packing:
+	 * ------------
+	 * I pack the data of each thread in a node. Unlike the static tree barrier, the wiring of the nodes is fixed by the algorithm, so the barrier itself
+	 * allocates the nodes (each one in its own cache-aligned storage) and the threads use the barrier through their logical id. The members of the barrier
+	 * object are read-only after construction.
+	 *
+	 * Alignment Requirements:
+	 * ----------------------
+	 * Each flag is padded to a cache line because every flag of a node is written by a different partner. The flags of a node are allocated in one array,
+	 * thus a hardware prefetcher could be an issue and tests must be made to validate the hypothesis.
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the number of threads:
+	 *		barrier::dissemination_barrier<4> barrier(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+	 */
+	template<unsigned int Radix = 2>
+	class dissemination_barrier{
+	public:
+		using size_type = unsigned int;
+
+		static_assert(Radix >= 2, "the radix of the dissemination barrier must be at least 2");
+
+		struct shared_flag{
+			std::atomic<bool> flag;
+			char _padding[CACHE_LINE_SIZE-sizeof(flag)];
+
+			shared_flag(){
+			 	flag = false;
+			}
+		};
+
+		// each node is allocated in cache-line boundaries
+		struct node{
+			// where my partners signal me: flags[parity*num_slots + slot]
+			shared_flag* flags;
+			// which flags of my partners should i signal: partner_flags[parity*num_slots + slot]
+			std::atomic<bool>** partner_flags;
+			size_type parity; // which set of flags to use in this episode
+			bool sense; // my local sense value
+		};
+
+		// Initialization is not atomic!
+		explicit dissemination_barrier(size_type n) : num_threads{n}, num_slots{0}{
+			assert(n > 0);
+
+			// compute the distance of each (round, j) pair and where each round ends
+			std::vector<size_type> distances;
+
+			for (unsigned long long stride = 1; stride < num_threads; stride *= Radix){
+				for (unsigned long long j = 1; j < Radix && j*stride < num_threads; ++j){
+					distances.push_back(static_cast<size_type>(j*stride));
+				}
+
+				round_end.push_back(static_cast<size_type>(distances.size()));
+			}
+
+			num_slots = static_cast<size_type>(distances.size());
+
+			// allocate the nodes
+			for (size_type i = 0; i < num_threads; ++i){
+				node* n = new (barrier::internal::cache_aligned_alloc(sizeof(node))) node();
+
+				n->flags = static_cast<shared_flag*>(barrier::internal::cache_aligned_alloc(2*num_slots*sizeof(shared_flag)));
+				for (size_type s = 0; s < 2*num_slots; ++s){
+					new (&n->flags[s]) shared_flag();
+				}
+				n->partner_flags = new std::atomic<bool>*[2*num_slots];
+				n->parity = 0;
+				n->sense = true;
+
+				nodes.push_back(n);
+			}
+
+			// now wire each node to the flags of its partners
+			for (size_type i = 0; i < num_threads; ++i){
+				for (size_type s = 0; s < num_slots; ++s){
+					node* partner = nodes[(i + distances[s]) % num_threads];
+
+					nodes[i]->partner_flags[s] = &partner->flags[s].flag;
+					nodes[i]->partner_flags[num_slots + s] = &partner->flags[num_slots + s].flag;
+				}
+			}
+		}
+
+		dissemination_barrier(const dissemination_barrier&) = delete;
+		dissemination_barrier& operator=(const dissemination_barrier&) = delete;
+
+		~dissemination_barrier(){
+			for (auto n : nodes){
+				barrier::internal::cache_aligned_free(n->flags);
+				delete [] n->partner_flags;
+				barrier::internal::cache_aligned_free(n);
+			}
+		}
+
+		void await(size_type id){
+			// relaxed version
+			assert(id < num_threads);
+			node* n = nodes[id];
+
+			const size_type base = n->parity*num_slots;
+			size_type s = 0;
+
+			for (auto end : round_end){
+				// signal my partners for this round and pass them the memory
+				for (size_type j = s; j < end; ++j){
+					n->partner_flags[base + j]->store(n->sense, std::memory_order_release);
+				}
+
+				// wait until my partners for this round signal me
+				for (; s < end; ++s){
+					while (n->flags[base + s].flag.load(std::memory_order_relaxed) != n->sense){}
+					n->flags[base + s].flag.load(std::memory_order_acquire); // sync memory
+				}
+			}
+
+			if (n->parity == 1){
+				n->sense = !n->sense;
+			}
+			n->parity = 1 - n->parity;
+		}
+
+	private:
+		const size_type num_threads; // how many threads are expected to arrive at the barrier?
+		size_type num_slots; // how many flags per parity each node has, that is how many signals each thread sends per episode
+		std::vector<size_type> round_end; // the slots of round r are [round_end[r-1], round_end[r])
+		std::vector<node*> nodes; // nodes[i] is the node of the thread with logical id i
+	};
+
+} // namespace barrier
+
+#endif
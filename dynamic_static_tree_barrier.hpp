@@ -0,0 +1,334 @@
+#ifndef __DYNAMIC_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__
+#define __DYNAMIC_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <algorithm>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+#include "memory_order_policy.hpp"
+#include "completion_function.hpp"
+#include "topology.hpp"
+#include "static_tree_layout.hpp"
+#include "static_tree_barrier.hpp"
+
+namespace barrier{
+
+	/**
+	 * Dynamic Static Tree Barrier:
+	 * ---------------------------
+	 *
+	 * This is the static tree barrier for a set of threads that changes between the phases (like the registration of a Java Phaser): a thread join()s
+	 * before its first phase and leave()s at its last one. The threads use the barrier through their logical id, which is at most max_threads-1 and gives
+	 * the place of the thread in the topology (see static_tree_layout.hpp), so a thread that joins is placed near the threads it shares caches with.
+	 *
+	 * The trees are repaired by the root at the phase boundaries: after everybody has arrived and before anybody departs, nobody reads the wiring of the
+	 * nodes, so the root applies the pending joins and leaves, builds the shapes of the new members and rewires only the links that have changed. The
+	 * departure then publishes the new wiring to the threads (they read it after they acquire their sense). Nothing is allocated or freed by the
+	 * repair: a node is allocated by the thread that first joins with its id (so it is placed near that thread) and kept for the next one.
+	 *	(1) leave(id): the thread registers its leave and arrives at the current phase without waiting for the departure (static_tree_barrier::
+	 *	arrive_and_drop()), thus its leave is seen by the root of that phase. It must not use the barrier through that id again, unless it joins again.
+	 *	(2) join(id): the thread registers its join and waits until the root of the current phase has wired it in and the departure of the phase reaches
+	 *	it (it may be an inner node of the new departure tree, so it passes the departure on). Then its first phase is the next one. When there are no
+	 *	members, the thread wires itself in at once. The thread spins until then: if the members never complete another phase (e.g. they wait for
+	 *	the joining thread outside the barrier), join() never returns.
+	 * The root checks for pending changes with a single load per phase, so when the membership does not change the barrier costs what static_tree_barrier
+	 * costs. The root is always the smallest member: when it changes, the repair also signals the departure to the new root, since the departure tree of
+	 * the old root no longer reaches it (the threads that get the departure twice get the same sense twice, which is harmless).
+	 *
+	 * The split-phase and reducing versions of static_tree_barrier are not offered: they read the wiring of a node between its arrival and its departure.
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the maximum number of threads and how many of them (the logical ids 0,...,num_threads-1) are members
+	 *	from the start:
+	 *		barrier::dynamic_static_tree_barrier<> barrier(max_threads, num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the member with logical id i use the barrier through await(i), and the threads join(i) and leave(i) as they come and go.
+	 */
+	template<class MemoryOrder = default_memory_order, unsigned int MaxFanIn = 8, unsigned int MaxFanOut = 8, class CompletionFunction = no_completion>
+	class dynamic_static_tree_barrier : private barrier::internal::completion_holder<CompletionFunction>{
+	public:
+		using size_type = unsigned int;
+		using memory_order_policy = MemoryOrder;
+
+	private:
+		// the completion function of the tree: repairs the trees and then runs the completion function of the client
+		struct membership_repair{
+			dynamic_static_tree_barrier* owner;
+
+			void operator()() const{
+				owner->complete_phase();
+			}
+		};
+
+	public:
+		using tree_barrier_type = static_tree_barrier<MemoryOrder, MaxFanIn, MaxFanOut, membership_repair>;
+		using node = typename tree_barrier_type::node;
+
+		// Initialization is not atomic!
+		explicit dynamic_static_tree_barrier(size_type max_threads, size_type num_threads, size_type fan_in = 2, size_type fan_out = 2,
+						     CompletionFunction completion = CompletionFunction())
+			: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), tree(membership_repair{this}), changed{false},
+			  nodes(max_threads, nullptr), member(max_threads, false), fan_in{fan_in}, fan_out{fan_out}, num_members{0}, root{0}, last_sense{true}{
+			assert(num_threads <= max_threads);
+			assert(fan_in > 0 && fan_in <= MaxFanIn && fan_out > 0 && fan_out <= MaxFanOut);
+
+			arrival_shape.children.resize(max_threads);
+			departure_shape.children.resize(max_threads);
+
+			if (num_threads == 0){
+				return;
+			}
+
+			std::vector<bool> fresh(max_threads, false);
+
+			for (size_type i = 0; i < num_threads; ++i){
+				admit(i);
+				fresh[i] = true;
+			}
+
+			rewire(fresh);
+		}
+
+		// for std_barrier_adapter: all the threads are members from the start
+		explicit dynamic_static_tree_barrier(size_type num_threads) : dynamic_static_tree_barrier(num_threads, num_threads){}
+
+		~dynamic_static_tree_barrier(){
+			for (auto n : nodes){
+				if (n != nullptr){
+					n->~node();
+					barrier::internal::cache_aligned_free(n);
+				}
+			}
+		}
+
+		dynamic_static_tree_barrier(const dynamic_static_tree_barrier&) = delete;
+		dynamic_static_tree_barrier& operator=(const dynamic_static_tree_barrier&) = delete;
+
+		void await(size_type id){
+			assert(id < nodes.size() && nodes[id] != nullptr);
+			tree.await(nodes[id]);
+		}
+
+		//! Makes the thread with the given logical id a member from the next phase on. Returns once the root has wired it in, thus spins forever if the
+		//! members never complete another phase.
+		void join(size_type id){
+			assert(id < nodes.size());
+
+			// the node is allocated by the joining thread, so it is placed near it
+			node* new_node = (nodes[id] == nullptr) ? new (barrier::internal::cache_aligned_alloc(sizeof(node))) node() : nullptr;
+
+			join_request request{id, {false}};
+			{
+				std::lock_guard<std::mutex> lock(membership_mutex);
+				// a thread may join again right after it has left, the repair applies the leaves first
+				assert(!member[id] || std::find(leaves.begin(), leaves.end(), id) != leaves.end());
+
+				if (new_node != nullptr){
+					nodes[id] = new_node;
+				}
+
+				if (num_members == 0){
+					// nobody uses the barrier, so i can wire myself in
+					admit(id);
+
+					std::vector<bool> fresh(nodes.size(), false);
+					fresh[id] = true;
+					rewire(fresh);
+
+					return;
+				}
+
+				joins.push_back(&request);
+				changed.store(true, std::memory_order_relaxed);
+			}
+
+			while (!request.admitted.load(std::memory_order_acquire)){}
+
+			// i may be inside the new departure tree, so i must pass on the departure of this phase like the members do
+			node* n = nodes[id];
+
+			while (n->sense.load(MemoryOrder::spin) == n->local_sense){}
+			MemoryOrder::acquire(n->sense); // sync memory
+
+			for (size_type c = 0; c < n->num_departure_children; ++c){
+				n->departure_children[c]->sense.store(!n->local_sense, MemoryOrder::signal); // also sync memory
+			}
+		}
+
+		//! Arrives at the current phase, which is the last phase of the thread with the given logical id
+		void leave(size_type id){
+			assert(id < nodes.size() && nodes[id] != nullptr);
+			{
+				std::lock_guard<std::mutex> lock(membership_mutex);
+				assert(member[id]);
+
+				leaves.push_back(id);
+				changed.store(true, std::memory_order_relaxed); // published to the root by my arrival
+			}
+
+			tree.arrive_and_drop(nodes[id]);
+		}
+
+		// as in std::barrier
+		void arrive_and_drop(size_type id){
+			leave(id);
+		}
+
+	private:
+		struct join_request{
+			size_type id;
+			std::atomic<bool> admitted;
+		};
+
+		// run by the root after everybody has arrived
+		void complete_phase(){
+			if (changed.load(std::memory_order_relaxed)){
+				std::lock_guard<std::mutex> lock(membership_mutex);
+				repair();
+			}
+
+			this->run_completion();
+		}
+
+		void repair(){
+			changed.store(false, std::memory_order_relaxed);
+
+			const size_type old_root = root;
+			const bool phase_sense = nodes[old_root]->local_sense; // the sense of the phase that ends now
+			last_sense = phase_sense;
+
+			for (auto id : leaves){
+				member[id] = false;
+				--num_members;
+			}
+			leaves.clear();
+
+			std::vector<bool> fresh(nodes.size(), false);
+
+			for (auto request : joins){
+				admit(request->id);
+				nodes[request->id]->sense = !phase_sense; // the joiner waits for the departure of this phase
+				fresh[request->id] = true;
+			}
+
+			// the old root signals the departure right after the repair: if it has left, it must signal nobody
+			if (!member[old_root]){
+				nodes[old_root]->num_departure_children = 0;
+			}
+
+			if (num_members != 0){
+				rewire(fresh);
+
+				if (root != old_root){
+					// the root never waits on its sense, so it may be that of the next phase. Now the old root will wait on it.
+					if (member[old_root]){
+						nodes[old_root]->sense.store(phase_sense, std::memory_order_relaxed);
+					}
+
+					// the departure tree of the old root does not reach the new root
+					nodes[root]->sense.store(phase_sense, MemoryOrder::signal); // also sync memory
+				}
+			}
+
+			for (auto request : joins){
+				request->admitted.store(true, std::memory_order_release); // the request is on the stack of the thread, which may return now
+			}
+			joins.clear();
+		}
+
+		// makes the id a member of the next phase, with the senses of the next phase
+		void admit(size_type id){
+			node* n = nodes[id];
+
+			if (n == nullptr){
+				// the members from the start are allocated by the constructor
+				n = nodes[id] = new (barrier::internal::cache_aligned_alloc(sizeof(node))) node();
+			}
+
+			n->sense = last_sense;
+			n->local_sense = !last_sense;
+
+			member[id] = true;
+			++num_members;
+		}
+
+		// builds the shapes of the members and writes only the links that have changed (all the links of the fresh members)
+		void rewire(const std::vector<bool>& fresh){
+			std::vector<size_type> members;
+
+			for (size_type i = 0; i < member.size(); ++i){
+				if (member[i]){
+					members.push_back(i);
+				}
+			}
+
+			static_tree_shape arrival = make_static_tree_shape(topo, members, nodes.size(), fan_in);
+			static_tree_shape departure = make_static_tree_shape(topo, members, nodes.size(), fan_out);
+
+			for (auto i : members){
+				node* n = nodes[i];
+				const auto& now = arrival.children[i];
+				const auto& before = arrival_shape.children[i];
+
+				for (std::size_t k = 0; k < now.size(); ++k){
+					if (fresh[i] || k >= before.size() || before[k] != now[k]){
+						n->arrival_children_flag[k].flag = last_sense; // not arrived at the next phase
+						nodes[now[k]]->arrival_parent = &n->arrival_children_flag[k];
+					}
+				}
+
+				if (fresh[i] || now.size() != before.size()){
+					n->num_arrival_children = now.size();
+				}
+
+				const auto& now_departure = departure.children[i];
+				const auto& before_departure = departure_shape.children[i];
+
+				for (std::size_t k = 0; k < now_departure.size(); ++k){
+					if (fresh[i] || k >= before_departure.size() || before_departure[k] != now_departure[k]){
+						n->departure_children[k] = nodes[now_departure[k]];
+					}
+				}
+
+				if (fresh[i] || now_departure.size() != before_departure.size()){
+					n->num_departure_children = now_departure.size();
+				}
+			}
+
+			root = arrival.root;
+			nodes[root]->arrival_parent = nullptr;
+
+			arrival_shape = std::move(arrival);
+			departure_shape = std::move(departure);
+		}
+
+		tree_barrier_type tree;
+		// set when a thread joins or leaves, the root reads it once per phase
+		std::atomic<bool> changed;
+		char _changed_padding[CACHE_LINE_SIZE-sizeof(changed)];
+
+		std::vector<node*> nodes; // nodes[i] is the node of the logical id i (nullptr before the first join)
+		// the rest is accessed under the mutex, or by the root at the phase boundary
+		std::mutex membership_mutex;
+		std::vector<bool> member;
+		std::vector<join_request*> joins;
+		std::vector<size_type> leaves;
+		const size_type fan_in;
+		const size_type fan_out;
+		size_type num_members;
+		size_type root; // the root of the current trees
+		bool last_sense; // the sense of the last phase that has ended
+		static_tree_shape arrival_shape;
+		static_tree_shape departure_shape;
+		barrier::internal::topology topo;
+	};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef __FIXED_SIZE_CENTRALIZED_SENSE_REVERSING_BARRIER_HPP_IS_INCLUDED__
+#define __FIXED_SIZE_CENTRALIZED_SENSE_REVERSING_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <cstddef>
+#include <atomic>
+#include "cache_line_size.hpp"
+#include "memory_order_policy.hpp"
+#include "prefetch_layout_policy.hpp"
+#include "centralized_sense_reversing_barrier.hpp"
+
+namespace barrier{
+
+/**
+ * Fixed Size Centralized Sense-Reversing Barrier:
+ * ----------------------------------------------
+ *
+ * This is the centralized sense-reversing barrier for a number of threads N known at compile time. The last thread is found by comparing the counter with
+ * a constant, so the barrier does not keep num_threads at all and the sense takes the whole last block. For N == 1 await() does nothing but flip the
+ * local sense.
+ *
+ * Data packing, alignment requirements and usage are those of the centralized sense-reversing barrier (the participants are the same). It also has the
+ * std::barrier interface, except for arrive_and_drop() which would change N.
+ */
+template<unsigned int N, class MemoryOrder = default_memory_order, class Layout = default_prefetch_layout>
+class fixed_size_centralized_sense_reversing_barrier{
+public:
+	using size_type = unsigned int;
+	using memory_order_policy = MemoryOrder;
+	using layout_policy = Layout;
+	using participant = typename centralized_sense_reversing_barrier<MemoryOrder, Layout>::participant;
+
+	static const size_type num_threads = N;
+
+	static_assert(N > 0, "the barrier needs at least one thread");
+
+	// Initialization is not atomic!
+	explicit fixed_size_centralized_sense_reversing_barrier(size_type n = N) : counter{0}, sense{true} {
+		assert(n == N);
+		(void)n;
+	}
+
+	void await(participant& p){
+		if (N > 1){
+			// arrive at the barrier
+			const size_type pre_arrived = counter.fetch_add(1, MemoryOrder::arrive);
+
+			if (pre_arrived + 1 == N){
+				// i am the last to arrive so reset and signal departure
+				// but first sync memory
+				MemoryOrder::acquire(counter);
+				counter.store(0, MemoryOrder::reset);
+				sense.store(p.local_sense, MemoryOrder::signal);
+			}
+			else{
+				// wait until the last one arrives
+				while (sense.load(MemoryOrder::spin) != p.local_sense){}
+				MemoryOrder::acquire(sense); // sync memory
+			}
+		}
+
+		p.local_sense = !p.local_sense;
+	}
+
+	// The std::barrier interface without arrive_and_drop(), since the number of threads is fixed (see centralized_sense_reversing_barrier).
+	using arrival_token = bool;
+
+	static constexpr std::ptrdiff_t max() noexcept{
+		return N;
+	}
+
+	arrival_token arrive(std::ptrdiff_t update = 1){
+		const bool current = sense.load(std::memory_order_relaxed);
+
+		if (N == 1){
+			return current; // the phase is over
+		}
+
+		// arrive at the barrier
+		const size_type pre_arrived = counter.fetch_add(static_cast<size_type>(update), MemoryOrder::arrive);
+		assert(update > 0 && pre_arrived + update <= N);
+
+		if (pre_arrived + update == N){
+			MemoryOrder::acquire(counter);
+			counter.store(0, MemoryOrder::reset);
+			sense.store(!current, MemoryOrder::signal);
+		}
+
+		return !current;
+	}
+
+	void wait(arrival_token token) const{
+		while (sense.load(MemoryOrder::spin) != token){}
+		MemoryOrder::acquire(sense); // sync memory
+	}
+
+	void arrive_and_wait(){
+		wait(arrive());
+	}
+
+private:
+	std::atomic<size_type> counter; // number of threads that have arrived
+	// the distance of the sense from the counter is given by the layout policy (see centralized_sense_reversing_barrier)
+	char false_sharing_counter_padding[Layout::hot_field_distance - sizeof(counter)];
+
+	std::atomic<bool> sense; // the sense value for the current barrier phase
+	char align_padding[Layout::block_size-sizeof(sense)];
+};
+
+} // namespace barrier
+
+#endif
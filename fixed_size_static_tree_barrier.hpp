@@ -0,0 +1,194 @@
+#ifndef __FIXED_SIZE_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__
+#define __FIXED_SIZE_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include "cache_line_size.hpp"
+#include "memory_order_policy.hpp"
+
+namespace barrier{
+
+namespace internal{
+
+	// the compile-time sequence of ids 0,...,N-1 (std::integer_sequence is C++14)
+	template<unsigned int... Ids>
+	struct id_sequence{};
+
+	template<unsigned int N, unsigned int... Ids>
+	struct make_id_sequence : make_id_sequence<N-1, N-1, Ids...>{};
+
+	template<unsigned int... Ids>
+	struct make_id_sequence<0, Ids...>{
+		using type = id_sequence<Ids...>;
+	};
+
+} // namespace internal
+
+	/**
+	 * Fixed Size Static Tree Barrier:
+	 * ------------------------------
+	 *
+	 * This is the static tree barrier for a number of threads N known at compile time (for example a fixed-size pool of workers). Since N is known, the
+	 * shape of the trees is computed at compile time: the arrival tree is the FanIn-ary tree where the children of i are FanIn*i+1,...,FanIn*i+FanIn and the
+	 * departure tree is the FanOut-ary tree built the same way (both are rooted at the thread 0). Then await<Id>() is instantiated for each logical id, so:
+	 *	(1) the loops over the arrival flags and the departure children are fully unrolled and have no bounds to load,
+	 *	(2) whether there is a parent to notify (the nullptr check on arrival_parent) is decided at compile time,
+	 *	(3) the parent's flag and the children's senses are found by constant offsets from the barrier, so the node keeps no pointers at all.
+	 * A thread that knows its id at compile time calls await<Id>(). Otherwise await(id) makes a single indirect call through a table of the await<Id>()
+	 * functions, which is always predicted correctly since each thread always uses the same entry.
+	 *
+	 * NOTE: the shape does not follow the topology of the machine (static_tree_layout.hpp reads it at run time). The thread with logical id j should be
+	 * pinned so that the threads j, FanIn*j+1, ..., FanIn*j+FanIn are close to each other, as it is the case with the affinity setter for small fans.
+	 *
+	 * Data Packing:
+	 * ------------
+	 * Each thread has a node with its sense (written by its departure parent), one flag per arrival child and its local sense. The barrier keeps the N nodes
+	 * in a std::array, so unlike static_tree_barrier the barrier itself is represented by a structure and the threads use it through their logical id.
+	 *
+	 * Alignment Requirements:
+	 * ----------------------
+	 * The nodes are aligned to cache-line boundaries (alignas) and every field that another thread writes takes a whole cache line. Thus the barrier must be
+	 * allocated to cache-line boundary: on the stack this is done by the compiler, on the heap use cache_aligned_alloc() and placement new. The nodes are now
+	 * in an array, so a hardware prefetcher may bring in the neighbour's line (see centralized_sense_reversing_barrier).
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance:
+	 *		barrier::fixed_size_static_tree_barrier<8> barrier;
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < N) use the barrier through await<i>() or await(i).
+	 */
+	template<unsigned int N, unsigned int FanIn = 4, unsigned int FanOut = 2, class MemoryOrder = default_memory_order>
+	class fixed_size_static_tree_barrier{
+	public:
+		using size_type = unsigned int;
+		using memory_order_policy = MemoryOrder;
+
+		static const size_type num_threads = N;
+		static const size_type fan_in = FanIn;
+		static const size_type fan_out = FanOut;
+
+		static_assert(N > 0 && FanIn > 0 && FanOut > 0, "the barrier needs at least one thread and the trees at least one child per node");
+
+		//! The number of children of the node id in the fan-ary tree
+		static constexpr size_type num_children(size_type id, size_type fan){
+			return (fan*id + 1 >= N) ? 0 : ((fan*id + fan < N) ? fan : N - 1 - fan*id);
+		}
+
+		//! The k-th child of the node id in the fan-ary tree
+		static constexpr size_type child(size_type id, size_type k, size_type fan){
+			return fan*id + 1 + k;
+		}
+
+		//! The parent of the node id (other than the root) in the fan-ary tree
+		static constexpr size_type parent(size_type id, size_type fan){
+			return (id - 1)/fan;
+		}
+
+		struct shared_flag{
+			std::atomic<bool> flag;
+			char _padding[CACHE_LINE_SIZE-sizeof(flag)];
+		};
+
+		struct alignas(CACHE_LINE_SIZE) node{
+			// where i expect my departure parent to signal me departure
+			std::atomic<bool> sense;
+			char _sense_padding[CACHE_LINE_SIZE-sizeof(sense)];
+			// one flag for each of the children that i may expect to arrive
+			shared_flag arrival_children_flag[FanIn];
+			bool local_sense; // my local sense value
+			char _local_sense_padding[CACHE_LINE_SIZE-sizeof(local_sense)];
+		};
+
+		// Initialization is not atomic!
+		explicit fixed_size_static_tree_barrier(size_type n = N) : await_table{make_await_table(typename internal::make_id_sequence<N>::type())}{
+			assert(n == N);
+			(void)n;
+
+			for (auto& nd : nodes){
+				nd.sense = true;
+				for (auto& f : nd.arrival_children_flag){
+					f.flag = true;
+				}
+				nd.local_sense = false;
+			}
+		}
+
+		fixed_size_static_tree_barrier(const fixed_size_static_tree_barrier&) = delete;
+		fixed_size_static_tree_barrier& operator=(const fixed_size_static_tree_barrier&) = delete;
+
+		template<size_type Id>
+		void await(){
+			static_assert(Id < N, "there is no such thread");
+			node& n = nodes[Id];
+
+			// wait until my children have arrived
+			wait_arrival_children<Id, 0>(n, std::integral_constant<bool, (0 < num_children(Id, FanIn))>());
+
+			// inform my parent of my subtree's arrival and wait for the departure (nothing to do for the root)
+			signal_arrival_and_wait_departure<Id>(n, std::integral_constant<bool, (Id == 0)>());
+
+			// now its time to signal children on departure tree
+			signal_departure_children<Id, 0>(n, std::integral_constant<bool, (0 < num_children(Id, FanOut))>());
+
+			n.local_sense = !n.local_sense;
+		}
+
+		void await(size_type id){
+			assert(id < N);
+			(this->*await_table[id])();
+		}
+
+	private:
+		using await_function = void (fixed_size_static_tree_barrier::*)();
+
+		template<size_type... Ids>
+		static const await_function* make_await_table(internal::id_sequence<Ids...>){
+			static const await_function table[] = {&fixed_size_static_tree_barrier::template await<Ids>...};
+			return table;
+		}
+
+		// the unrolled loops: C is the child to handle, the tag tells whether it exists
+
+		template<size_type Id, size_type C>
+		void wait_arrival_children(node& n, std::true_type){
+			while (n.arrival_children_flag[C].flag.load(MemoryOrder::spin) != n.local_sense){}
+			MemoryOrder::acquire(n.arrival_children_flag[C].flag); // sync memory
+
+			wait_arrival_children<Id, C + 1>(n, std::integral_constant<bool, (C + 1 < num_children(Id, FanIn))>());
+		}
+
+		template<size_type Id, size_type C>
+		void wait_arrival_children(node&, std::false_type){}
+
+		template<size_type Id>
+		void signal_arrival_and_wait_departure(node& n, std::false_type){
+			nodes[parent(Id, FanIn)].arrival_children_flag[(Id - 1) % FanIn].flag.store(n.local_sense, MemoryOrder::signal);
+
+			// wait now until my parent signals departure
+			while (n.sense.load(MemoryOrder::spin) != n.local_sense){}
+			MemoryOrder::acquire(n.sense); // sync memory
+		}
+
+		template<size_type Id>
+		void signal_arrival_and_wait_departure(node&, std::true_type){}
+
+		template<size_type Id, size_type C>
+		void signal_departure_children(node& n, std::true_type){
+			nodes[child(Id, C, FanOut)].sense.store(n.local_sense, MemoryOrder::signal); // also sync memory
+
+			signal_departure_children<Id, C + 1>(n, std::integral_constant<bool, (C + 1 < num_children(Id, FanOut))>());
+		}
+
+		template<size_type Id, size_type C>
+		void signal_departure_children(node&, std::false_type){}
+
+		const await_function* const await_table; // await_table[i] is &await<i>. Read-only, the nodes start at the next cache line.
+		std::array<node, N> nodes;
+	};
+
+} // namespace barrier
+
+#endif
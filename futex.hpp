@@ -0,0 +1,30 @@
+#ifndef __FUTEX_HPP_IS_INCLUDED__
+#define __FUTEX_HPP_IS_INCLUDED__ 1
+
+#include <atomic>
+#include <climits>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace barrier{
+
+namespace internal{
+
+		static_assert(sizeof(std::atomic<int>) == sizeof(int), "a futex word must be a plain int");
+
+		// Sleeps as long as word has the value expected. May return spuriously, so the caller must re-check the word.
+		inline void futex_wait(std::atomic<int>& word, int expected){
+			syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+		}
+
+		// Wakes all the threads sleeping on word.
+		inline void futex_wake_all(std::atomic<int>& word){
+			syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+		}
+
+} // namespace internal
+
+} // namespace barrier
+
+#endif
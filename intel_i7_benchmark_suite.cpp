@@ -4,6 +4,36 @@
  * The benchmark is invoked as:
  *	./prog_name BarrierClass OutFile
  * The benchmark then proceeds in using the barrier specified by BarrierClass and writing the results to a file named Outfile.
+ * BarrierClass is one of:
+ *	centralized_sense_reversing_barrier
+ *	centralized_sense_reversing_barrier_prefetch_pair (the compact prefetch_pair_layout)
+ *	centralized_spin_then_park_barrier
+ *	centralized_generation_barrier (the counter and the sense in one 64-bit word)
+ *	centralized_signal_wait_barrier (half the threads are producers that signal(), the others consumers that wait(), see run_experiment_signal_wait_barrier())
+ *	sharded_centralized_sense_reversing_barrier (one arrival counter per L3 domain under a top counter, a single sense)
+ *	static_tree_barrier
+ *	static_tree_barrier_global_departure
+ *	static_tree_barrier_fan_sweep (one OutFile_FanIn<k>_FanOut<m> per fan-in/fan-out pair)
+ *	static_tree_barrier_global_departure_fan_sweep (one OutFile_FanIn<k> per fan-in)
+ *	centralized_sense_reversing_barrier_memory_order_sweep (one OutFile_<Policy> per memory order policy)
+ *	static_tree_barrier_memory_order_sweep (one OutFile_<Policy> per memory order policy)
+ *	static_tree_barrier_global_departure_memory_order_sweep (one OutFile_<Policy> per memory order policy)
+ *	dissemination_barrier (radix 2)
+ *	dissemination_barrier_radix4
+ *	tournament_barrier
+ *	mcs_tree_barrier
+ *	fixed_size_static_tree_barrier (one instantiation per number of threads)
+ *	fixed_size_centralized_sense_reversing_barrier (one instantiation per number of threads)
+ *	smt_combining_static_tree_barrier (the SMT siblings combine in a line of their core, one thread per core in the static tree)
+ *	smt_combining_static_tree_barrier_global_departure (the same with the global departure)
+ *	adaptive_barrier (switches between the centralized and the global departure tree barriers by their sampled cost)
+ *	numa_hierarchical_barrier (a centralized barrier per socket under a centralized barrier of the sockets)
+ *	straggler_aware_static_tree_barrier (the threads that arrive late are moved near the root of the static tree)
+ *	dynamic_static_tree_barrier (the membership does not change, to compare with static_tree_barrier)
+ *	dynamic_static_tree_barrier_churn (the threads leave and join again every 100 phases, see run_experiment_dynamic_membership())
+ *	centralized_sense_reversing_barrier_std_interface (through arrive_and_wait(), without participants)
+ *	static_tree_barrier_std_adapter (through std_barrier_adapter, the threads bound at their first arrival)
+ *	std_barrier (the std::barrier of the standard library, only when compiled as C++20: make STD=c++20)
  *
  * The benchmark run is:
  *	For number of threads from 1 to 8
@@ -41,8 +71,28 @@
 #include "profile.hpp"
 #include "affinity.hpp"
 #include "centralized_sense_reversing_barrier.hpp"
+#include "centralized_spin_then_park_barrier.hpp"
+#include "centralized_generation_barrier.hpp"
+#include "centralized_signal_wait_barrier.hpp"
 #include "static_tree_barrier.hpp"
 #include "static_tree_barrier_global_departure.hpp"
+#include "static_tree_layout.hpp"
+#include "dissemination_barrier.hpp"
+#include "tournament_barrier.hpp"
+#include "mcs_tree_barrier.hpp"
+#include "fixed_size_static_tree_barrier.hpp"
+#include "fixed_size_centralized_sense_reversing_barrier.hpp"
+#include "logical_id_static_tree_barrier.hpp"
+#include "smt_combining_tree_barrier.hpp"
+#include "dynamic_static_tree_barrier.hpp"
+#include "numa_hierarchical_barrier.hpp"
+#include "sharded_centralized_sense_reversing_barrier.hpp"
+#include "adaptive_barrier.hpp"
+#include "straggler_aware_static_tree_barrier.hpp"
+#include "std_barrier_adapter.hpp"
+#if __cplusplus >= 202002L
+#include <barrier>
+#endif
 
 /**
  * A helper object to simulate random workload.
@@ -70,7 +120,10 @@ struct random_workload{
 
 // The function returns a vector of vectors that contain the (lower,mean,upper) latencies. 
 // The first vector denotes the number of threads and the inner vector the workload parameter
-std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_centralized_sense_reversing_barrier(){
+// Only the numbers of threads from min_threads to max_threads are run, the other rows are left zero (see run_fixed_size_experiment()).
+template<class Barrier>
+std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_centralized_sense_reversing_barrier(std::size_t min_threads = 1,
+													      std::size_t max_threads = 8){
 	std::vector<std::vector<std::tuple<double,double,double> > > data;
 
 	const std::size_t workloads [] = {1,10,100};
@@ -82,17 +135,21 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_cent
 		data[i].resize(workload_size);
 	}
 
-	auto thread_job = [](barrier::centralized_sense_reversing_barrier& barrier, std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
+	auto thread_job = [](Barrier& barrier, std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
 		const std::size_t num_episodes = 10000;
 
 		random_workload work{workload, seed};
 
+		// my local sense for the barrier, allocated by me to cache-line boundary
+		typename std::aligned_storage<sizeof(typename Barrier::participant),CACHE_LINE_SIZE>::type participant_storage;
+		typename Barrier::participant* participant = new (&participant_storage) typename Barrier::participant();
+
 		// wait until we are told to start
 		while (!start_flag.load()){}
 
 		for (std::size_t i = 0; i < num_episodes; ++i){
 			work();
-			barrier.await();
+			barrier.await(*participant);
 		}
 	};
 
@@ -100,7 +157,7 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_cent
 
 	barrier::internal::affinity aff_setter;
 
-	for (std::size_t num_threads = 1; num_threads <= 8; ++num_threads){
+	for (std::size_t num_threads = min_threads; num_threads <= max_threads; ++num_threads){
 		for (std::size_t workload_index = 0; workload_index < workload_size; ++workload_index){
 			const std::size_t workload = workloads[workload_index];
 			std::cout << "Executing experiment with " << num_threads << " threads and " << workload << " workload parameter." << std::endl;
@@ -126,9 +183,10 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_cent
 
 
 				// create the barrier instance
-				std::aligned_storage<sizeof(barrier::centralized_sense_reversing_barrier),CACHE_LINE_SIZE>::type barrier;
+				// aligned to the prefetch granularity, which the compact layouts need
+				typename std::aligned_storage<sizeof(Barrier),PREFETCH_GRANULARITY>::type barrier;
 				
-				new(&barrier) barrier::centralized_sense_reversing_barrier(num_threads); 
+				new(&barrier) Barrier(num_threads); 
 
 				// clear the caches
 				{
@@ -144,7 +202,7 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_cent
 				std::atomic<bool> start_flag{false};
 
 				for (int j = 0; j < num_threads; ++j){
-					std::thread t = std::thread{thread_job,std::ref(*static_cast<barrier::centralized_sense_reversing_barrier*>(
+					std::thread t = std::thread{thread_job,std::ref(*static_cast<Barrier*>(
 								static_cast<void*>(&barrier))), 
 								workload, seeds[j], std::ref(start_flag)};
 					std::thread::native_handle_type t_handle = t.native_handle();
@@ -173,6 +231,136 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_cent
 }
 
 
+// Runs the experiment for a barrier with producers and consumers (centralized_signal_wait_barrier): of the N threads, the first (N+1)/2 are producers
+// which perform their workload and signal() each episode without waiting, and the others are consumers which wait() for each episode and then perform
+// their workload. The barrier is constructed with the number of producers only, the consumers are not counted.
+template<class Barrier>
+std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_signal_wait_barrier(){
+	std::vector<std::vector<std::tuple<double,double,double> > > data;
+
+	const std::size_t workloads [] = {1,10,100};
+	const std::size_t workload_size = sizeof(workloads)/sizeof(workloads[0]);
+
+	data.resize(8);
+	
+	for (std::size_t i = 0; i < data.size(); ++i){
+		data[i].resize(workload_size);
+	}
+
+	const std::size_t num_episodes = 10000;
+
+	auto producer_job = [num_episodes](Barrier& barrier, std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
+		random_workload work{workload, seed};
+
+		// my phase for the barrier, allocated by me to cache-line boundary
+		typename std::aligned_storage<sizeof(typename Barrier::participant),CACHE_LINE_SIZE>::type participant_storage;
+		typename Barrier::participant* participant = new (&participant_storage) typename Barrier::participant();
+
+		// wait until we are told to start
+		while (!start_flag.load()){}
+
+		for (std::size_t i = 0; i < num_episodes; ++i){
+			work();
+			barrier.signal(*participant);
+		}
+	};
+
+	auto consumer_job = [num_episodes](Barrier& barrier, std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
+		random_workload work{workload, seed};
+
+		// the phase i wait for, allocated by me to cache-line boundary
+		typename std::aligned_storage<sizeof(typename Barrier::waiter),CACHE_LINE_SIZE>::type waiter_storage;
+		typename Barrier::waiter* waiter = new (&waiter_storage) typename Barrier::waiter();
+
+		// wait until we are told to start
+		while (!start_flag.load()){}
+
+		for (std::size_t i = 0; i < num_episodes; ++i){
+			barrier.wait(*waiter);
+			work();
+		}
+	};
+
+	std::cout << "Starting the experiment" << std::endl;
+
+	barrier::internal::affinity aff_setter;
+
+	for (std::size_t num_threads = 1; num_threads <= 8; ++num_threads){
+		const std::size_t num_producers = (num_threads + 1)/2;
+
+		for (std::size_t workload_index = 0; workload_index < workload_size; ++workload_index){
+			const std::size_t workload = workloads[workload_index];
+			std::cout << "Executing experiment with " << num_producers << " producers, " << num_threads - num_producers << " consumers and "
+				  << workload << " workload parameter." << std::endl;
+
+			// with a confidence interval
+			const std::size_t num_times{30};
+
+			barrier::internal::confidence_interval mean(num_times);
+
+
+			// create the random seeds for the threads. Each of the num_times times each thread must start with the same seed!
+			// this is a requirement for reproducability
+			std::vector<std::mt19937::result_type> seeds;
+			 			
+			std::mt19937 rnd(1337);
+
+			for (std::size_t i = 0; i < num_threads; ++i){
+				seeds.push_back(rnd());
+			}
+
+			for (std::size_t i = 0; i < num_times; ++i){
+				std::cout << "\t..." << i;
+
+
+				// create the barrier instance with the number of producers
+				// aligned to the prefetch granularity, which the compact layouts need
+				typename std::aligned_storage<sizeof(Barrier),PREFETCH_GRANULARITY>::type barrier;
+				
+				new(&barrier) Barrier(num_producers); 
+
+				// clear the caches
+				{
+					std::cout << "\tClearing caches" << std::endl;
+					barrier::internal::cache_wiper cw;
+
+					cw.clear_caches();
+				}
+
+
+				// create the threads
+				std::vector<std::thread> threads;
+				std::atomic<bool> start_flag{false};
+
+				for (std::size_t j = 0; j < num_threads; ++j){
+					Barrier& b = *static_cast<Barrier*>(static_cast<void*>(&barrier));
+					std::thread t = (j < num_producers) ? std::thread{producer_job, std::ref(b), workload, seeds[j], std::ref(start_flag)}
+									    : std::thread{consumer_job, std::ref(b), workload, seeds[j], std::ref(start_flag)};
+					std::thread::native_handle_type t_handle = t.native_handle();
+					threads.push_back(std::move(t));
+
+					aff_setter(num_threads, j, t_handle);
+				}
+					
+				auto start_time = std::chrono::steady_clock::now();
+				start_flag = true;
+				// wait for the threads to finish
+				std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+				auto end_time = std::chrono::steady_clock::now();
+				double elapsed_time = std::chrono::duration<double,std::nano>(end_time-start_time).count();
+
+				mean.add(elapsed_time);				
+			}
+
+
+			// now record the result
+			data[num_threads-1][workload_index] = mean.mean();
+		}
+	}
+
+	return data;
+}
+
 void write_data_to_file(std::vector<std::vector<std::tuple<double,double,double>>> data, std::string out_file){
 	std::cout << "Writing data to file " << out_file << std::endl;
 
@@ -251,17 +439,21 @@ void test_thread_mapping(){
 }*/
 
 void perf_friendly_version(){
-	auto thread_job = [](barrier::centralized_sense_reversing_barrier& barrier, std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
+	auto thread_job = [](barrier::centralized_sense_reversing_barrier<>& barrier, std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
 		const std::size_t num_episodes = 10000000;
 
 		random_workload work{workload, seed};
 
+		// my local sense for the barrier, allocated by me to cache-line boundary
+		std::aligned_storage<sizeof(barrier::centralized_sense_reversing_barrier<>::participant),CACHE_LINE_SIZE>::type participant_storage;
+		auto participant = new (&participant_storage) barrier::centralized_sense_reversing_barrier<>::participant();
+
 		// wait until we are told to start
 		while (!start_flag.load()){}
 
 		for (std::size_t i = 0; i < num_episodes; ++i){
 			work();
-			barrier.await();
+			barrier.await(*participant);
 		}
 	};
 
@@ -285,9 +477,9 @@ void perf_friendly_version(){
 	}
 
 	// create the barrier instance
-	std::aligned_storage<sizeof(barrier::centralized_sense_reversing_barrier),CACHE_LINE_SIZE>::type barrier;
+	std::aligned_storage<sizeof(barrier::centralized_sense_reversing_barrier<>),CACHE_LINE_SIZE>::type barrier;
 				
-	new(&barrier) barrier::centralized_sense_reversing_barrier(num_threads); 
+	new(&barrier) barrier::centralized_sense_reversing_barrier<>(num_threads); 
 
 	// clear the caches
 	{
@@ -303,7 +495,7 @@ void perf_friendly_version(){
 	std::atomic<bool> start_flag{false};
 
 	for (int j = 0; j < num_threads; ++j){
-		std::thread t = std::thread{thread_job,std::ref(*static_cast<barrier::centralized_sense_reversing_barrier*>(
+		std::thread t = std::thread{thread_job,std::ref(*static_cast<barrier::centralized_sense_reversing_barrier<>*>(
 						static_cast<void*>(&barrier))), 
 						workload, seeds[j], std::ref(start_flag)};
 		std::thread::native_handle_type t_handle = t.native_handle();
@@ -326,23 +518,27 @@ void perf_friendly_version(){
 // that should be used by thread with logical id 0. Also the function connects the nodes together.
 //
 // The first version static_tree_layout_good_locality() makes a good locality whereas the static_tree_layout_bad_locality() makes a bad locality.
+// The good locality layout is built from the machine topology (see static_tree_layout.hpp) and works for any number of threads. The bad locality
+// layout is still shaped by hand for the i7-2600K, its only purpose is to be compared against the good one.
 
-std::vector<barrier::static_tree_barrier::node* > static_tree_layout_good_locality(std::size_t num_threads){
-	using raw_cache_aligned_node = std::aligned_storage<sizeof(barrier::static_tree_barrier::node),CACHE_LINE_SIZE>::type;
+template<class Barrier>
+std::vector<typename Barrier::node* > static_tree_layout_good_locality(const barrier::internal::topology& topo, std::size_t num_threads,
+											       std::size_t fan_in, std::size_t fan_out){
+	using raw_cache_aligned_node = typename std::aligned_storage<sizeof(typename Barrier::node),CACHE_LINE_SIZE>::type;
 	std::vector<raw_cache_aligned_node*> cache_aligned_data;
 
 	for (std::size_t i = 0; i < num_threads; ++i){
 		cache_aligned_data.push_back(new raw_cache_aligned_node());
 
 		// and construct a node there
-		new (cache_aligned_data[i]) barrier::static_tree_barrier::node();
+		new (cache_aligned_data[i]) typename Barrier::node();
 	}
 
 	// now create the vector to return to the clients
-	std::vector<barrier::static_tree_barrier::node* > nodes;
+	std::vector<typename Barrier::node* > nodes;
 
 	for (std::size_t i = 0; i < num_threads; ++i){
-		nodes.push_back(static_cast<barrier::static_tree_barrier::node*>(static_cast<void*>(cache_aligned_data[i])));
+		nodes.push_back(static_cast<typename Barrier::node*>(static_cast<void*>(cache_aligned_data[i])));
 	}
 
 
@@ -352,200 +548,33 @@ std::vector<barrier::static_tree_barrier::node* > static_tree_layout_good_locali
 		nodes[i]->local_sense = false;
 	}
 
-	// do the layout.. and do it the hard way!!
-	switch(num_threads){
-	case 1:
-		nodes[0]->arrival_parent = nullptr;
-		break;
-	case 2:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(1);
-		nodes[0]->departure_children.push_back(&nodes[1]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		break;
-	case 3:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[1]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		break;
-	case 4:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[1]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
-		nodes[2]->departure_children.push_back(&nodes[3]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		break;
-	case 5:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-		nodes[0]->departure_children.push_back(&nodes[4]->sense);
-
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(1);
-		nodes[4]->departure_children.push_back(&nodes[1]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
-		nodes[2]->departure_children.push_back(&nodes[3]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		
-		break;
-	case 6:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-		nodes[0]->departure_children.push_back(&nodes[4]->sense);
-
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(2);
-		nodes[4]->departure_children.push_back(&nodes[1]->sense);
-		nodes[4]->departure_children.push_back(&nodes[5]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
-		nodes[2]->departure_children.push_back(&nodes[3]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[4]->arrival_children_flag[1];
-
-		break;
-	case 7:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-		nodes[0]->departure_children.push_back(&nodes[4]->sense);
-
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(2);
-		nodes[4]->departure_children.push_back(&nodes[1]->sense);
-		nodes[4]->departure_children.push_back(&nodes[5]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(2);
-		nodes[2]->departure_children.push_back(&nodes[3]->sense);
-		nodes[2]->departure_children.push_back(&nodes[6]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[4]->arrival_children_flag[1];
-
-		// for node 6
-		nodes[6]->arrival_parent = &nodes[2]->arrival_children_flag[1];
-		break;
-	case 8:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-		nodes[0]->departure_children.push_back(&nodes[4]->sense);
-
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(2);
-		nodes[4]->departure_children.push_back(&nodes[1]->sense);
-		nodes[4]->departure_children.push_back(&nodes[5]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(2);
-		nodes[2]->departure_children.push_back(&nodes[3]->sense);
-		nodes[2]->departure_children.push_back(&nodes[6]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		nodes[3]->arrival_children_flag.resize(1);
-		nodes[3]->departure_children.push_back(&nodes[7]->sense);
-
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[4]->arrival_children_flag[1];
-
-		// for node 6
-		nodes[6]->arrival_parent = &nodes[2]->arrival_children_flag[1];
-
-		// for node 7
-		nodes[7]->arrival_parent = &nodes[3]->arrival_children_flag[0];
-		break;
-	default:
-		assert(0);
-	};
+	// do the layout from the machine topology
+	const barrier::static_tree_shape arrival_shape = barrier::make_static_tree_shape(topo, num_threads, fan_in);
+	const barrier::static_tree_shape departure_shape = barrier::make_static_tree_shape(topo, num_threads, fan_out);
 
-	// perform initialization of shared flags
-	for (std::size_t i = 0; i < num_threads; ++i){
-		for (std::size_t j = 0; j < nodes[i]->arrival_children_flag.size(); ++j){
-			nodes[i]->arrival_children_flag[j].flag = true;
-		}
-	}
+	barrier::wire_arrival_tree(nodes, arrival_shape);
+	barrier::wire_departure_tree(nodes, departure_shape);
 
 	return std::move(nodes);
 }
 
-std::vector<barrier::static_tree_barrier::node* > static_tree_layout_bad_locality(std::size_t num_threads){
-	using raw_cache_aligned_node = std::aligned_storage<sizeof(barrier::static_tree_barrier::node),CACHE_LINE_SIZE>::type;
+template<class Barrier>
+std::vector<typename Barrier::node* > static_tree_layout_bad_locality(std::size_t num_threads){
+	using raw_cache_aligned_node = typename std::aligned_storage<sizeof(typename Barrier::node),CACHE_LINE_SIZE>::type;
 	std::vector<raw_cache_aligned_node*> cache_aligned_data;
 
 	for (std::size_t i = 0; i < num_threads; ++i){
 		cache_aligned_data.push_back(new raw_cache_aligned_node());
 
 		// and construct a node there
-		new (cache_aligned_data[i]) barrier::static_tree_barrier::node();
+		new (cache_aligned_data[i]) typename Barrier::node();
 	}
 
 	// now create the vector to return to the clients
-	std::vector<barrier::static_tree_barrier::node* > nodes;
+	std::vector<typename Barrier::node* > nodes;
 
 	for (std::size_t i = 0; i < num_threads; ++i){
-		nodes.push_back(static_cast<barrier::static_tree_barrier::node*>(static_cast<void*>(cache_aligned_data[i])));
+		nodes.push_back(static_cast<typename Barrier::node*>(static_cast<void*>(cache_aligned_data[i])));
 	}
 
 
@@ -555,189 +584,58 @@ std::vector<barrier::static_tree_barrier::node* > static_tree_layout_bad_localit
 		nodes[i]->local_sense = false;
 	}
 
-	// do the layout.. and do it the hard way!!
+	// do the layout.. and do it the hard way!! The same shape is used for both the arrival and the departure tree.
+	barrier::static_tree_shape shape;
+	shape.root = 0;
+	shape.children.resize(num_threads);
+
 	switch(num_threads){
 	case 1:
-		nodes[0]->arrival_parent = nullptr;
 		break;
 	case 2:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(1);
-		nodes[0]->departure_children.push_back(&nodes[1]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
+		shape.children[0] = {1};
 		break;
 	case 3:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[1]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
+		shape.children[0] = {1, 2};
 		break;
 	case 4:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[3]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
-		nodes[2]->departure_children.push_back(&nodes[1]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-
+		shape.children[0] = {3, 2};
+		shape.children[2] = {1};
 		break;
 	case 5:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[3]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
-		nodes[2]->departure_children.push_back(&nodes[1]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[3]->arrival_children_flag.resize(1);
-		nodes[3]->departure_children.push_back(&nodes[4]->sense);		
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[3]->arrival_children_flag[0];
-
+		shape.children[0] = {3, 2};
+		shape.children[2] = {1};
+		shape.children[3] = {4};
 		break;
 	case 6:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[3]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(2);
-		nodes[2]->departure_children.push_back(&nodes[1]->sense);
-		nodes[2]->departure_children.push_back(&nodes[5]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[3]->arrival_children_flag.resize(1);
-		nodes[3]->departure_children.push_back(&nodes[4]->sense);		
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[3]->arrival_children_flag[0];
-
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[2]->arrival_children_flag[1];
-		
+		shape.children[0] = {3, 2};
+		shape.children[2] = {1, 5};
+		shape.children[3] = {4};
 		break;
 	case 7:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[3]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(2);
-		nodes[2]->departure_children.push_back(&nodes[1]->sense);
-		nodes[2]->departure_children.push_back(&nodes[5]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[3]->arrival_children_flag.resize(1);
-		nodes[3]->departure_children.push_back(&nodes[4]->sense);		
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[3]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(1);
-		nodes[4]->departure_children.push_back(&nodes[6]->sense);
-
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[2]->arrival_children_flag[1];
-
-		// for node 6
-		nodes[6]->arrival_parent = &nodes[4]->arrival_children_flag[0];
-
+		shape.children[0] = {3, 2};
+		shape.children[2] = {1, 5};
+		shape.children[3] = {4};
+		shape.children[4] = {6};
 		break;
 	case 8:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
-		nodes[0]->departure_children.push_back(&nodes[3]->sense);
-		nodes[0]->departure_children.push_back(&nodes[2]->sense);
-
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(2);
-		nodes[2]->departure_children.push_back(&nodes[1]->sense);
-		nodes[2]->departure_children.push_back(&nodes[5]->sense);
-
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[3]->arrival_children_flag.resize(1);
-		nodes[3]->departure_children.push_back(&nodes[4]->sense);		
-
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[3]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(2);
-		nodes[4]->departure_children.push_back(&nodes[6]->sense);
-		nodes[4]->departure_children.push_back(&nodes[7]->sense);
-
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[2]->arrival_children_flag[1];
-
-		// for node 6
-		nodes[6]->arrival_parent = &nodes[4]->arrival_children_flag[0];
-		
-		// for node 7
-		nodes[7]->arrival_parent = &nodes[4]->arrival_children_flag[1];
-
+		shape.children[0] = {3, 2};
+		shape.children[2] = {1, 5};
+		shape.children[3] = {4};
+		shape.children[4] = {6, 7};
 		break;
 	default:
 		assert(0);
 	};
 
-	// perform initialization of shared flags
-	for (std::size_t i = 0; i < num_threads; ++i){
-		for (std::size_t j = 0; j < nodes[i]->arrival_children_flag.size(); ++j){
-			nodes[i]->arrival_children_flag[j].flag = true;
-		}
-	}
+	barrier::wire_arrival_tree(nodes, shape);
+	barrier::wire_departure_tree(nodes, shape);
 
 	return std::move(nodes);
 }
 
-std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_static_tree_barrier(){
+template<class Barrier>
+std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_static_tree_barrier(std::size_t fan_in = 2, std::size_t fan_out = 2){
 	std::vector<std::vector<std::tuple<double,double,double> > > data;
 
 	const std::size_t workloads [] = {1,10,100};
@@ -749,8 +647,8 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 		data[i].resize(workload_size);
 	}
 
-	auto thread_job = [](barrier::static_tree_barrier& barrier, 
-			    barrier::static_tree_barrier::node* node,
+	auto thread_job = [](Barrier& barrier, 
+			    typename Barrier::node* node,
 			    std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
 		const std::size_t num_episodes = 10000;
 
@@ -768,6 +666,7 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 	std::cout << "Starting the experiment" << std::endl;
 
 	barrier::internal::affinity aff_setter;
+	barrier::internal::topology topo;
 
 	for (std::size_t num_threads = 1; num_threads <= 8; ++num_threads){
 		for (std::size_t workload_index = 0; workload_index < workload_size; ++workload_index){
@@ -795,9 +694,9 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 
 
 				// create the barrier instance
-				std::aligned_storage<sizeof(barrier::static_tree_barrier),CACHE_LINE_SIZE>::type barrier;
+				typename std::aligned_storage<sizeof(Barrier),CACHE_LINE_SIZE>::type barrier;
 				
-				new(&barrier) barrier::static_tree_barrier(); 
+				new(&barrier) Barrier(); 
 
 				// clear the caches
 				{
@@ -809,8 +708,8 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 
 				// creating the nodes
 				std::cout << "\t...Creating nodes..." << std::endl;
-				std::vector<barrier::static_tree_barrier::node*> nodes = static_tree_layout_good_locality(num_threads);				
-				//std::vector<barrier::static_tree_barrier::node*> nodes = static_tree_layout_bad_locality(num_threads);	
+				std::vector<typename Barrier::node*> nodes = static_tree_layout_good_locality<Barrier>(topo, num_threads, fan_in, fan_out);				
+				//std::vector<typename Barrier::node*> nodes = static_tree_layout_bad_locality<Barrier>(num_threads);	
 
 				// create the threads
 				std::cout << "\t...Creating threads..." << std::endl;
@@ -818,7 +717,7 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 				std::atomic<bool> start_flag{false};
 
 				for (int j = 0; j < num_threads; ++j){
-					std::thread t = std::thread{thread_job,std::ref(*static_cast<barrier::static_tree_barrier*>(
+					std::thread t = std::thread{thread_job,std::ref(*static_cast<Barrier*>(
 								static_cast<void*>(&barrier))), 
 								nodes[j],
 								workload, seeds[j], std::ref(start_flag)};
@@ -852,22 +751,24 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 	return data;
 }
 
-std::vector<barrier::static_tree_barrier_global_departure::node* > static_tree_global_departure_layout_good_locality(std::size_t num_threads){
-	using raw_cache_aligned_node = std::aligned_storage<sizeof(barrier::static_tree_barrier_global_departure::node),CACHE_LINE_SIZE>::type;
+template<class Barrier>
+std::vector<typename Barrier::node* > static_tree_global_departure_layout_good_locality(const barrier::internal::topology& topo, 
+															     std::size_t num_threads, std::size_t fan_in){
+	using raw_cache_aligned_node = typename std::aligned_storage<sizeof(typename Barrier::node),CACHE_LINE_SIZE>::type;
 	std::vector<raw_cache_aligned_node*> cache_aligned_data;
 
 	for (std::size_t i = 0; i < num_threads; ++i){
 		cache_aligned_data.push_back(new raw_cache_aligned_node());
 
 		// and construct a node there
-		new (cache_aligned_data[i]) barrier::static_tree_barrier_global_departure::node();
+		new (cache_aligned_data[i]) typename Barrier::node();
 	}
 
 	// now create the vector to return to the clients
-	std::vector<barrier::static_tree_barrier_global_departure::node* > nodes;
+	std::vector<typename Barrier::node* > nodes;
 
 	for (std::size_t i = 0; i < num_threads; ++i){
-		nodes.push_back(static_cast<barrier::static_tree_barrier_global_departure::node*>(static_cast<void*>(cache_aligned_data[i])));
+		nodes.push_back(static_cast<typename Barrier::node*>(static_cast<void*>(cache_aligned_data[i])));
 	}
 
 
@@ -876,158 +777,135 @@ std::vector<barrier::static_tree_barrier_global_departure::node* > static_tree_g
 		nodes[i]->local_sense = false;
 	}
 
-	// do the layout.. and do it the hard way!!
-	switch(num_threads){
-	case 1:
-		nodes[0]->arrival_parent = nullptr;
-		break;
-	case 2:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(1);
+	// do the layout from the machine topology. There is no departure tree.
+	const barrier::static_tree_shape arrival_shape = barrier::make_static_tree_shape(topo, num_threads, fan_in);
 
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		break;
-	case 3:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
+	barrier::wire_arrival_tree(nodes, arrival_shape);
 
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
+	return std::move(nodes);
+}
 
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		break;
-	case 4:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
 
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[0]->arrival_children_flag[0];
+template<class Barrier>
+std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_static_tree_barrier_global_departure(std::size_t fan_in = 2){
+	std::vector<std::vector<std::tuple<double,double,double> > > data;
 
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
+	const std::size_t workloads [] = {1,10,100};
+	const std::size_t workload_size = sizeof(workloads)/sizeof(workloads[0]);
 
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		break;
-	case 5:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
+	data.resize(8);
+	
+	for (std::size_t i = 0; i < data.size(); ++i){
+		data[i].resize(workload_size);
+	}
 
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(1);
+	auto thread_job = [](Barrier& barrier, 
+			    typename Barrier::node* node,
+			    std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
+		const std::size_t num_episodes = 10000;
 
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
+		random_workload work{workload, seed};
 
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
+		// wait until we are told to start
+		while (!start_flag.load()){}
 
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		
-		break;
-	case 6:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
+		for (std::size_t i = 0; i < num_episodes; ++i){
+			work();
+			barrier.await(node);
+		}
+	};
 
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(2);
+	std::cout << "Starting the experiment" << std::endl;
 
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
+	barrier::internal::affinity aff_setter;
+	barrier::internal::topology topo;
 
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(1);
+	for (std::size_t num_threads = 1; num_threads <= 8; ++num_threads){
+		for (std::size_t workload_index = 0; workload_index < workload_size; ++workload_index){
+			const std::size_t workload = workloads[workload_index];
+			std::cout << "Executing experiment with " << num_threads << " threads and " << workload << " workload parameter." << std::endl;
 
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
+			// with a confidence interval
+			const std::size_t num_times{30};
 
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[4]->arrival_children_flag[1];
+			barrier::internal::confidence_interval mean(num_times);
 
-		break;
-	case 7:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
 
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(2);
+			// create the random seeds for the threads. Each of the num_times times each thread must start with the same seed!
+			// this is a requirement for reproducability
+			std::vector<std::mt19937::result_type> seeds;
+			 			
+			std::mt19937 rnd(1337);
 
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
+			for (std::size_t i = 0; i < num_threads; ++i){
+				seeds.push_back(rnd());
+			}
 
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(2);
+			for (std::size_t i = 0; i < num_times; ++i){
+				std::cout << "\t..." << i;
 
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
 
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[4]->arrival_children_flag[1];
+				// create the barrier instance
+				typename std::aligned_storage<sizeof(Barrier),CACHE_LINE_SIZE>::type barrier;
+				
+				new(&barrier) Barrier(); 
 
-		// for node 6
-		nodes[6]->arrival_parent = &nodes[2]->arrival_children_flag[1];
-		break;
-	case 8:
-		// for node 0
-		nodes[0]->arrival_parent = nullptr;
-		nodes[0]->arrival_children_flag.resize(2);
+				// clear the caches
+				{
+					std::cout << "\tClearing caches" << std::endl;
+					barrier::internal::cache_wiper cw;
 
-		// for node 4
-		nodes[4]->arrival_parent = &nodes[0]->arrival_children_flag[0];
-		nodes[4]->arrival_children_flag.resize(2);
+					cw.clear_caches();
+				}
 
-		// for node 1
-		nodes[1]->arrival_parent = &nodes[4]->arrival_children_flag[0];
+				// creating the nodes
+				std::cout << "\t...Creating nodes..." << std::endl;
+				std::vector<typename Barrier::node*> nodes = static_tree_global_departure_layout_good_locality<Barrier>(topo, num_threads, fan_in);				
+				
+				// create the threads
+				std::cout << "\t...Creating threads..." << std::endl;
+				std::vector<std::thread> threads;
+				std::atomic<bool> start_flag{false};
 
-		// for node 2
-		nodes[2]->arrival_parent = &nodes[0]->arrival_children_flag[1];
-		nodes[2]->arrival_children_flag.resize(2);
+				for (int j = 0; j < num_threads; ++j){
+					std::thread t = std::thread{thread_job,std::ref(*static_cast<Barrier*>(
+								static_cast<void*>(&barrier))), 
+								nodes[j],
+								workload, seeds[j], std::ref(start_flag)};
+					std::thread::native_handle_type t_handle = t.native_handle();
+					threads.push_back(std::move(t));
 
-		// for node 3
-		nodes[3]->arrival_parent = &nodes[2]->arrival_children_flag[0];
-		nodes[3]->arrival_children_flag.resize(1);
+					aff_setter(num_threads, j, t_handle);
+				}
+					
+				auto start_time = std::chrono::steady_clock::now();
+				start_flag = true;
+				// wait for the threads to finish
+				std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+				auto end_time = std::chrono::steady_clock::now();
+				double elapsed_time = std::chrono::duration<double,std::nano>(end_time-start_time).count();
 
-		// for node 5
-		nodes[5]->arrival_parent = &nodes[4]->arrival_children_flag[1];
+				mean.add(elapsed_time);	
 
-		// for node 6
-		nodes[6]->arrival_parent = &nodes[2]->arrival_children_flag[1];
+				// release the nodes
+				for (std::size_t i = 0; i < num_threads; ++i){
+					delete nodes[i];
+				}			
+			}
 
-		// for node 7
-		nodes[7]->arrival_parent = &nodes[3]->arrival_children_flag[0];
-		break;
-	default:
-		assert(0);
-	};
 
-	// perform initialization of shared flags
-	for (std::size_t i = 0; i < num_threads; ++i){
-		for (std::size_t j = 0; j < nodes[i]->arrival_children_flag.size(); ++j){
-			nodes[i]->arrival_children_flag[j].flag = true;
+			// now record the result
+			data[num_threads-1][workload_index] = mean.mean();
 		}
 	}
 
-	return std::move(nodes);
+	return data;
 }
 
-
-std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_static_tree_barrier_global_departure(){
+// Runs the experiment for the barriers that allocate their own nodes and are used through the logical id of the thread (await(id)).
+// Only the numbers of threads from min_threads to max_threads are run, the other rows are left zero (see run_fixed_size_experiment()).
+template<class Barrier>
+std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_logical_id_barrier(std::size_t min_threads = 1, std::size_t max_threads = 8){
 	std::vector<std::vector<std::tuple<double,double,double> > > data;
 
 	const std::size_t workloads [] = {1,10,100};
@@ -1039,8 +917,8 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 		data[i].resize(workload_size);
 	}
 
-	auto thread_job = [](barrier::static_tree_barrier_global_departure& barrier, 
-			    barrier::static_tree_barrier_global_departure::node* node,
+	auto thread_job = [](Barrier& barrier, 
+			    unsigned int id,
 			    std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag){	
 		const std::size_t num_episodes = 10000;
 
@@ -1051,7 +929,7 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 
 		for (std::size_t i = 0; i < num_episodes; ++i){
 			work();
-			barrier.await(node);
+			barrier.await(id);
 		}
 	};
 
@@ -1059,7 +937,7 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 
 	barrier::internal::affinity aff_setter;
 
-	for (std::size_t num_threads = 1; num_threads <= 8; ++num_threads){
+	for (std::size_t num_threads = min_threads; num_threads <= max_threads; ++num_threads){
 		for (std::size_t workload_index = 0; workload_index < workload_size; ++workload_index){
 			const std::size_t workload = workloads[workload_index];
 			std::cout << "Executing experiment with " << num_threads << " threads and " << workload << " workload parameter." << std::endl;
@@ -1084,10 +962,8 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 				std::cout << "\t..." << i;
 
 
-				// create the barrier instance
-				std::aligned_storage<sizeof(barrier::static_tree_barrier_global_departure),CACHE_LINE_SIZE>::type barrier;
-				
-				new(&barrier) barrier::static_tree_barrier_global_departure(); 
+				// create the barrier instance. The barrier allocates the cache-aligned nodes by itself.
+				Barrier barrier(num_threads);
 
 				// clear the caches
 				{
@@ -1097,19 +973,13 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 					cw.clear_caches();
 				}
 
-				// creating the nodes
-				std::cout << "\t...Creating nodes..." << std::endl;
-				std::vector<barrier::static_tree_barrier_global_departure::node*> nodes = static_tree_global_departure_layout_good_locality(num_threads);				
-				
 				// create the threads
 				std::cout << "\t...Creating threads..." << std::endl;
 				std::vector<std::thread> threads;
 				std::atomic<bool> start_flag{false};
 
-				for (int j = 0; j < num_threads; ++j){
-					std::thread t = std::thread{thread_job,std::ref(*static_cast<barrier::static_tree_barrier_global_departure*>(
-								static_cast<void*>(&barrier))), 
-								nodes[j],
+				for (unsigned int j = 0; j < num_threads; ++j){
+					std::thread t = std::thread{thread_job, std::ref(barrier), j,
 								workload, seeds[j], std::ref(start_flag)};
 					std::thread::native_handle_type t_handle = t.native_handle();
 					threads.push_back(std::move(t));
@@ -1125,11 +995,161 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 				double elapsed_time = std::chrono::duration<double,std::nano>(end_time-start_time).count();
 
 				mean.add(elapsed_time);	
+			}
 
-				// release the nodes
-				for (std::size_t i = 0; i < num_threads; ++i){
-					delete nodes[i];
-				}			
+
+			// now record the result
+			data[num_threads-1][workload_index] = mean.mean();
+		}
+	}
+
+	return data;
+}
+
+// Runs the experiment for a barrier whose membership changes between the phases (dynamic_static_tree_barrier), with the same workloads as
+// run_experiment_logical_id_barrier(). Every churn_period phases of its own, each thread changes its membership:
+//	the thread 0, the root of the trees, leaves and joins again every 4*churn_period phases, so the root changes twice;
+//	the threads with an odd id leave, perform a workload outside the barrier and join again;
+//	the other threads leave and join again at once, before the phase of their leave has ended.
+// Each thread leaves at its last episode. Then the thread 1 joins again and performs churn_period episodes alone, while the thread 0 leaves as the last
+// member.
+template<class Barrier>
+std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_dynamic_membership(std::size_t churn_period = 100){
+	std::vector<std::vector<std::tuple<double,double,double> > > data;
+
+	const std::size_t workloads [] = {1,10,100};
+	const std::size_t workload_size = sizeof(workloads)/sizeof(workloads[0]);
+
+	data.resize(8);
+	
+	for (std::size_t i = 0; i < data.size(); ++i){
+		data[i].resize(workload_size);
+	}
+
+	auto thread_job = [churn_period](Barrier& barrier, 
+					 unsigned int id, std::size_t num_threads,
+					 std::size_t workload, std::mt19937::result_type seed, std::atomic<bool>& start_flag,
+					 std::atomic<std::size_t>& num_left){	
+		const std::size_t num_episodes = 10000;
+		const std::size_t leader_period = 4*churn_period;
+
+		random_workload work{workload, seed};
+
+		// wait until we are told to start
+		while (!start_flag.load()){}
+
+		for (std::size_t i = 0; i + 1 < num_episodes; ++i){
+			work();
+
+			if (id == 0 && i % leader_period == leader_period - 1){
+				barrier.leave(id);
+				barrier.join(id);
+			}
+			// staggered, so that the threads do not all leave at the same phase
+			else if (id != 0 && i % churn_period == (id * 7) % churn_period){
+				barrier.leave(id);
+
+				if (id % 2 == 1){
+					work();
+				}
+
+				barrier.join(id);
+			}
+			else{
+				barrier.await(id);
+			}
+		}
+
+		work();
+
+		if (id == 0){
+			// the others may be behind me (they miss the phases they are out of), so i keep arriving until all of them have left
+			while (num_left.load() + 1 < num_threads){
+				barrier.await(id);
+			}
+
+			// the thread 1 may be joining now
+			barrier.leave(id);
+			return;
+		}
+
+		barrier.leave(id);
+		++num_left;
+
+		if (id == 1){
+			barrier.join(id);
+
+			for (std::size_t i = 0; i < churn_period; ++i){
+				barrier.await(id);
+			}
+
+			barrier.leave(id);
+		}
+	};
+
+	std::cout << "Starting the experiment" << std::endl;
+
+	barrier::internal::affinity aff_setter;
+
+	for (std::size_t num_threads = 1; num_threads <= 8; ++num_threads){
+		for (std::size_t workload_index = 0; workload_index < workload_size; ++workload_index){
+			const std::size_t workload = workloads[workload_index];
+			std::cout << "Executing experiment with " << num_threads << " threads and " << workload << " workload parameter." << std::endl;
+
+			// with a confidence interval
+			const std::size_t num_times{30};
+
+			barrier::internal::confidence_interval mean(num_times);
+
+
+			// create the random seeds for the threads. Each of the num_times times each thread must start with the same seed!
+			// this is a requirement for reproducability
+			std::vector<std::mt19937::result_type> seeds;
+			 			
+			std::mt19937 rnd(1337);
+
+			for (std::size_t i = 0; i < num_threads; ++i){
+				seeds.push_back(rnd());
+			}
+
+			for (std::size_t i = 0; i < num_times; ++i){
+				std::cout << "\t..." << i;
+
+
+				// create the barrier instance with all the threads as members. The barrier allocates the cache-aligned nodes by itself.
+				Barrier barrier(num_threads, num_threads);
+
+				// clear the caches
+				{
+					std::cout << "\tClearing caches" << std::endl;
+					barrier::internal::cache_wiper cw;
+
+					cw.clear_caches();
+				}
+
+				// create the threads
+				std::cout << "\t...Creating threads..." << std::endl;
+				std::vector<std::thread> threads;
+				std::atomic<bool> start_flag{false};
+				std::atomic<std::size_t> num_left{0};
+
+				for (unsigned int j = 0; j < num_threads; ++j){
+					std::thread t = std::thread{thread_job, std::ref(barrier), j, num_threads,
+								workload, seeds[j], std::ref(start_flag), std::ref(num_left)};
+					std::thread::native_handle_type t_handle = t.native_handle();
+					threads.push_back(std::move(t));
+
+					aff_setter(num_threads, j, t_handle);
+				}
+					
+				auto start_time = std::chrono::steady_clock::now();
+				start_flag = true;
+				// wait for the threads to finish
+				std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+				auto end_time = std::chrono::steady_clock::now();
+				double elapsed_time = std::chrono::duration<double,std::nano>(end_time-start_time).count();
+
+				mean.add(elapsed_time);	
 			}
 
 
@@ -1141,10 +1161,242 @@ std::vector<std::vector<std::tuple<double,double,double> > > run_experiment_stat
 	return data;
 }
 
+// The fan-in and fan-out values swept by the *_fan_sweep barrier classes
+const std::size_t swept_fan_in [] = {2,3,4,8};
+const std::size_t swept_fan_out [] = {1,2,3,4};
+
+// Runs the static tree barrier for every (fan-in, fan-out) pair. The results of each pair are written to a file named OutFile_FanIn<k>_FanOut<m>.
+void sweep_static_tree_barrier(std::string out_file){
+	for (auto fan_in : swept_fan_in){
+		for (auto fan_out : swept_fan_out){
+			std::cout << "Sweeping fan-in " << fan_in << " and fan-out " << fan_out << std::endl;
+
+			auto data = run_experiment_static_tree_barrier<barrier::static_tree_barrier<> >(fan_in, fan_out);
+
+			write_data_to_file(data, out_file + "_FanIn" + std::to_string(fan_in) + "_FanOut" + std::to_string(fan_out));
+		}
+	}
+}
+
+// Runs the static tree barrier with global departure for every fan-in (there is no departure tree). The results of each fan-in are written to a file
+// named OutFile_FanIn<k>.
+void sweep_static_tree_barrier_global_departure(std::string out_file){
+	for (auto fan_in : swept_fan_in){
+		std::cout << "Sweeping fan-in " << fan_in << std::endl;
+
+		auto data = run_experiment_static_tree_barrier_global_departure<barrier::static_tree_barrier_global_departure<> >(fan_in);
+
+		write_data_to_file(data, out_file + "_FanIn" + std::to_string(fan_in));
+	}
+}
+
+// Adapters from a memory order policy to the experiment of each barrier class, so that sweep_memory_order() can instantiate all of them
+struct centralized_sense_reversing_barrier_experiment{
+	template<class MemoryOrder>
+	static std::vector<std::vector<std::tuple<double,double,double> > > run(){
+		return run_experiment_centralized_sense_reversing_barrier<barrier::centralized_sense_reversing_barrier<MemoryOrder> >();
+	}
+};
+
+struct static_tree_barrier_experiment{
+	template<class MemoryOrder>
+	static std::vector<std::vector<std::tuple<double,double,double> > > run(){
+		return run_experiment_static_tree_barrier<barrier::static_tree_barrier<MemoryOrder> >();
+	}
+};
+
+struct static_tree_barrier_global_departure_experiment{
+	template<class MemoryOrder>
+	static std::vector<std::vector<std::tuple<double,double,double> > > run(){
+		return run_experiment_static_tree_barrier_global_departure<barrier::static_tree_barrier_global_departure<MemoryOrder> >();
+	}
+};
+
+// Adapters from a number of threads to the experiment of each fixed-size barrier class, so that run_fixed_size_experiment() can instantiate them
+struct fixed_size_static_tree_barrier_experiment{
+	template<unsigned int N>
+	static std::vector<std::vector<std::tuple<double,double,double> > > run(){
+		return run_experiment_logical_id_barrier<barrier::fixed_size_static_tree_barrier<N> >(N, N);
+	}
+};
+
+struct fixed_size_centralized_sense_reversing_barrier_experiment{
+	template<unsigned int N>
+	static std::vector<std::vector<std::tuple<double,double,double> > > run(){
+		return run_experiment_centralized_sense_reversing_barrier<barrier::fixed_size_centralized_sense_reversing_barrier<N> >(N, N);
+	}
+};
+
+// Runs a barrier with the interface of std::barrier in run_experiment_logical_id_barrier(): each thread calls arrive_and_wait() and the logical id is not
+// used. Aligned so that the barrier on the stack starts at a PREFETCH_GRANULARITY boundary.
+template<class Barrier>
+struct alignas(PREFETCH_GRANULARITY) std_interface_barrier : Barrier{
+	explicit std_interface_barrier(std::size_t num_threads) : Barrier(num_threads){}
+
+	void await(unsigned int){
+		this->arrive_and_wait();
+	}
+};
+
+// Runs a barrier used through await(id) that must start at a block boundary in run_experiment_logical_id_barrier(), which keeps it on the stack.
+template<class Barrier>
+struct alignas(PREFETCH_GRANULARITY) aligned_logical_id_barrier : Barrier{
+	explicit aligned_logical_id_barrier(std::size_t num_threads) : Barrier(num_threads){}
+};
+
+// The fixed-size barriers need one instantiation per number of threads. This runs the experiment for 1,...,N threads and keeps the row of each one.
+template<class Experiment, unsigned int N>
+struct fixed_size_experiment_runner{
+	static void run(std::vector<std::vector<std::tuple<double,double,double> > >& data){
+		fixed_size_experiment_runner<Experiment, N - 1>::run(data);
+		data[N - 1] = Experiment::template run<N>()[N - 1];
+	}
+};
+
+template<class Experiment>
+struct fixed_size_experiment_runner<Experiment, 0>{
+	static void run(std::vector<std::vector<std::tuple<double,double,double> > >&){}
+};
+
+template<class Experiment>
+std::vector<std::vector<std::tuple<double,double,double> > > run_fixed_size_experiment(){
+	std::vector<std::vector<std::tuple<double,double,double> > > data(8);
+
+	fixed_size_experiment_runner<Experiment, 8>::run(data);
+
+	return data;
+}
+
+// Runs the experiment of a barrier class once for every memory order policy. The results of each policy are written to a file named
+// OutFile_SeqCst, OutFile_AcqRel, OutFile_RelaxedAcquireLoad and OutFile_RelaxedAcquireFence.
+template<class Experiment>
+void sweep_memory_order(std::string out_file){
+	std::cout << "Sweeping memory order seq_cst" << std::endl;
+	write_data_to_file(Experiment::template run<barrier::seq_cst_memory_order>(), out_file + "_SeqCst");
+
+	std::cout << "Sweeping memory order acq_rel" << std::endl;
+	write_data_to_file(Experiment::template run<barrier::acq_rel_memory_order>(), out_file + "_AcqRel");
+
+	std::cout << "Sweeping memory order relaxed with acquire load" << std::endl;
+	write_data_to_file(Experiment::template run<barrier::relaxed_acquire_load_memory_order>(), out_file + "_RelaxedAcquireLoad");
+
+	std::cout << "Sweeping memory order relaxed with acquire fence" << std::endl;
+	write_data_to_file(Experiment::template run<barrier::relaxed_acquire_fence_memory_order>(), out_file + "_RelaxedAcquireFence");
+}
+
 int main(int argc, const char* argv[]){	
-	std::string out_file = "StaticTreeBarrierGlobalDepartureRelaxedWithGoodLocality";
+	if (argc != 3){
+		std::cerr << "Usage: " << argv[0] << " BarrierClass OutFile" << std::endl;
+		return (1);
+	}
+
+	const std::string barrier_class = argv[1];
+	const std::string out_file = argv[2];
+
+	// the sweeps write one file per configuration
+	if (barrier_class == "static_tree_barrier_fan_sweep"){
+		sweep_static_tree_barrier(out_file);
+		return (0);
+	}
+	else if (barrier_class == "static_tree_barrier_global_departure_fan_sweep"){
+		sweep_static_tree_barrier_global_departure(out_file);
+		return (0);
+	}
+	else if (barrier_class == "centralized_sense_reversing_barrier_memory_order_sweep"){
+		sweep_memory_order<centralized_sense_reversing_barrier_experiment>(out_file);
+		return (0);
+	}
+	else if (barrier_class == "static_tree_barrier_memory_order_sweep"){
+		sweep_memory_order<static_tree_barrier_experiment>(out_file);
+		return (0);
+	}
+	else if (barrier_class == "static_tree_barrier_global_departure_memory_order_sweep"){
+		sweep_memory_order<static_tree_barrier_global_departure_experiment>(out_file);
+		return (0);
+	}
+
+	std::vector<std::vector<std::tuple<double,double,double> > > data;
 
-	auto data = run_experiment_static_tree_barrier_global_departure();
+	if (barrier_class == "centralized_sense_reversing_barrier"){
+		data = run_experiment_centralized_sense_reversing_barrier<barrier::centralized_sense_reversing_barrier<> >();
+	}
+	else if (barrier_class == "centralized_sense_reversing_barrier_prefetch_pair"){
+		data = run_experiment_centralized_sense_reversing_barrier<barrier::centralized_sense_reversing_barrier<barrier::default_memory_order,
+			barrier::prefetch_pair_layout> >();
+	}
+	else if (barrier_class == "centralized_spin_then_park_barrier"){
+		data = run_experiment_centralized_sense_reversing_barrier<barrier::centralized_spin_then_park_barrier<> >();
+	}
+	else if (barrier_class == "static_tree_barrier"){
+		data = run_experiment_static_tree_barrier<barrier::static_tree_barrier<> >();
+	}
+	else if (barrier_class == "static_tree_barrier_global_departure"){
+		data = run_experiment_static_tree_barrier_global_departure<barrier::static_tree_barrier_global_departure<> >();
+	}
+	else if (barrier_class == "dissemination_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::dissemination_barrier<2> >();
+	}
+	else if (barrier_class == "dissemination_barrier_radix4"){
+		data = run_experiment_logical_id_barrier<barrier::dissemination_barrier<4> >();
+	}
+	else if (barrier_class == "tournament_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::tournament_barrier>();
+	}
+	else if (barrier_class == "mcs_tree_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::mcs_tree_barrier>();
+	}
+	else if (barrier_class == "fixed_size_static_tree_barrier"){
+		data = run_fixed_size_experiment<fixed_size_static_tree_barrier_experiment>();
+	}
+	else if (barrier_class == "fixed_size_centralized_sense_reversing_barrier"){
+		data = run_fixed_size_experiment<fixed_size_centralized_sense_reversing_barrier_experiment>();
+	}
+	else if (barrier_class == "centralized_signal_wait_barrier"){
+		data = run_experiment_signal_wait_barrier<barrier::centralized_signal_wait_barrier<> >();
+	}
+	else if (barrier_class == "centralized_generation_barrier"){
+		data = run_experiment_logical_id_barrier<std_interface_barrier<barrier::centralized_generation_barrier<> > >();
+	}
+	else if (barrier_class == "sharded_centralized_sense_reversing_barrier"){
+		data = run_experiment_logical_id_barrier<aligned_logical_id_barrier<barrier::sharded_centralized_sense_reversing_barrier<> > >();
+	}
+	else if (barrier_class == "smt_combining_static_tree_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::smt_combining_tree_barrier<barrier::static_tree_barrier<> > >();
+	}
+	else if (barrier_class == "smt_combining_static_tree_barrier_global_departure"){
+		data = run_experiment_logical_id_barrier<barrier::smt_combining_tree_barrier<barrier::static_tree_barrier_global_departure<> > >();
+	}
+	else if (barrier_class == "adaptive_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::adaptive_barrier<> >();
+	}
+	else if (barrier_class == "numa_hierarchical_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::numa_hierarchical_barrier<> >();
+	}
+	else if (barrier_class == "straggler_aware_static_tree_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::straggler_aware_static_tree_barrier<> >();
+	}
+	else if (barrier_class == "dynamic_static_tree_barrier"){
+		data = run_experiment_logical_id_barrier<barrier::dynamic_static_tree_barrier<> >();
+	}
+	else if (barrier_class == "dynamic_static_tree_barrier_churn"){
+		data = run_experiment_dynamic_membership<barrier::dynamic_static_tree_barrier<> >();
+	}
+	else if (barrier_class == "centralized_sense_reversing_barrier_std_interface"){
+		data = run_experiment_logical_id_barrier<std_interface_barrier<barrier::centralized_sense_reversing_barrier<> > >();
+	}
+	else if (barrier_class == "static_tree_barrier_std_adapter"){
+		data = run_experiment_logical_id_barrier<std_interface_barrier<barrier::std_barrier_adapter<
+			barrier::logical_id_static_tree_barrier<barrier::static_tree_barrier<> > > > >();
+	}
+#if defined(__cpp_lib_barrier)
+	else if (barrier_class == "std_barrier"){
+		data = run_experiment_logical_id_barrier<std_interface_barrier<std::barrier<> > >();
+	}
+#endif
+	else{
+		std::cerr << "Unknown barrier class " << barrier_class << std::endl;
+		return (1);
+	}
 	
 	write_data_to_file(data, out_file);
 	
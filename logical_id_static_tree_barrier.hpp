@@ -0,0 +1,120 @@
+#ifndef __LOGICAL_ID_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__
+#define __LOGICAL_ID_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <new>
+#include <utility>
+#include <vector>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+#include "topology.hpp"
+#include "static_tree_layout.hpp"
+
+namespace barrier{
+
+namespace internal{
+
+	// the departure tree of the barriers that have one (static_tree_barrier), chosen by overloading on whether the node has departure_children
+	template<class Node>
+	auto wire_departure_tree_if_any(const std::vector<Node*>& nodes, const static_tree_shape& shape, int)
+		-> decltype((void)nodes[0]->departure_children, void()){
+		for (auto n : nodes){
+			n->sense = true;
+		}
+
+		wire_departure_tree(nodes, shape);
+	}
+
+	// static_tree_barrier_global_departure departs through the global sense of the barrier
+	template<class Node>
+	void wire_departure_tree_if_any(const std::vector<Node*>&, const static_tree_shape&, long){}
+
+} // namespace internal
+
+	/**
+	 * Logical Id Static Tree Barrier:
+	 * ------------------------------
+	 *
+	 * The static tree barriers (static_tree_barrier and static_tree_barrier_global_departure) leave the nodes to the client, so that the client can place
+	 * them near the threads that use them. This class does the usual thing instead: it allocates one cache-aligned node per thread, wires the trees from the
+	 * topology of the machine (see static_tree_layout.hpp) and lets the threads use the barrier through their logical id, like the dissemination, tournament
+	 * and MCS tree barriers. Thus all the barriers can be used the same way, for example behind std_barrier_adapter.
+	 *
+	 * The nodes are allocated by the constructing thread, so they are placed near it and not near the threads that use them.
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the number of threads (and the fans of the trees):
+	 *		barrier::logical_id_static_tree_barrier<barrier::static_tree_barrier<> > barrier(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i) or the split-phase arrive(i) and wait(token),
+	 *	or the other methods of the tree barrier with tree_barrier() and node(i).
+	 */
+	template<class TreeBarrier>
+	class logical_id_static_tree_barrier{
+	public:
+		using size_type = unsigned int;
+		using tree_barrier_type = TreeBarrier;
+		using node_type = typename TreeBarrier::node;
+
+		// Initialization is not atomic! The arguments after the fans are passed to the tree barrier (its completion function).
+		template<class... Args>
+		explicit logical_id_static_tree_barrier(size_type n, size_type fan_in = 2, size_type fan_out = 2, Args&&... args)
+			: nodes(n), tree(std::forward<Args>(args)...){
+			assert(n > 0);
+
+			for (size_type i = 0; i < n; ++i){
+				nodes[i] = new (barrier::internal::cache_aligned_alloc(sizeof(node_type))) node_type();
+				nodes[i]->local_sense = false;
+			}
+
+			barrier::internal::topology topo;
+
+			wire_arrival_tree(nodes, make_static_tree_shape(topo, n, fan_in));
+			barrier::internal::wire_departure_tree_if_any(nodes, make_static_tree_shape(topo, n, fan_out), 0);
+		}
+
+		~logical_id_static_tree_barrier(){
+			for (auto n : nodes){
+				n->~node_type();
+				barrier::internal::cache_aligned_free(n);
+			}
+		}
+
+		logical_id_static_tree_barrier(const logical_id_static_tree_barrier&) = delete;
+		logical_id_static_tree_barrier& operator=(const logical_id_static_tree_barrier&) = delete;
+
+		void await(size_type id){
+			assert(id < nodes.size());
+			tree.await(nodes[id]);
+		}
+
+		// the split-phase arrival of the tree barrier (see static_tree_barrier), through the logical id
+		using arrival_token = typename TreeBarrier::arrival_token;
+
+		arrival_token arrive(size_type id){
+			assert(id < nodes.size());
+			return tree.arrive(nodes[id]);
+		}
+
+		void wait(arrival_token token){
+			tree.wait(token);
+		}
+
+		TreeBarrier& tree_barrier(){
+			return tree;
+		}
+
+		node_type* node(size_type id) const{
+			assert(id < nodes.size());
+			return nodes[id];
+		}
+
+	private:
+		std::vector<node_type*> nodes; // read-only after construction
+		alignas(CACHE_LINE_SIZE) TreeBarrier tree; // the global departure barrier writes its sense here
+	};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef __MCS_TREE_BARRIER_HPP_IS_INCLUDED__
+#define __MCS_TREE_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+
+namespace barrier{
+
+	/**
+	 * MCS Tree Barrier:
+	 * ----------------
+	 *
+	 * This is the tree barrier of Mellor-Crummey and Scott. The arrival tree is 4-ary: the parent of the thread with logical id i is (i-1)/4. The departure
+	 * tree is a separate binary wakeup tree: the children of the thread with logical id i are 2i+1 and 2i+2.
+	 *
+	 * The difference from the static tree barrier is in the arrival flags. Here the (up to) four children of a node share a single 32-bit word and each child
+	 * owns a bit of it. Thus the parent does a single word-compare spin on one cache line instead of spinning across one cache line per child, and the
+	 * parent's arrival-phase misses drop from k to 1. The flags use the local sense: a child sets its bit (fetch_or) when its local sense is true and clears
+	 * it (fetch_and) when it is false, and the parent waits until the bits of all its children equal its local sense. The bits of children that do not
+	 * exist are never written and are masked out. The original writes a byte per child with a plain store, but a byte store and a word load of the same
+	 * location are not both atomic operations in C++, so here the children pay a read-modify-write of the shared word instead.
+	 *
+	 * Each thread has the following data:
+	 *	(1) Where do my children signal their arrival? std::atomic<std::uint32_t> arrival_children (one bit per child)
+	 *	(2) Which children do i have? std::uint32_t arrival_children_mask (the bit of each existing child)
+	 *	(3) Which word and which bit should i write upon arrival? std::atomic<std::uint32_t>* arrival_parent (nullptr for the root) and
+	 *	std::uint32_t arrival_bit
+	 *	(4) Where should my wakeup parent notify me about the departure? std::atomic<bool> sense
+	 *	(5) Which children should i notify for the departure? std::atomic<bool>* departure_children[2]
+	 *	(6) Which is my local sense? bool local_sense
+	 *
+	 * Data Packing:
+	 * ------------
+	 * I pack the data of each thread in a node. The wiring of the nodes is fixed by the algorithm, so as in the dissemination barrier the barrier itself
+	 * allocates the nodes and the threads use the barrier through their logical id. There are no heap-allocated vectors in the node, so await() does not
+	 * chase any pointer other than the ones to the parent's word and to the departure children.
+	 *
+	 * Alignment Requirements:
+	 * ----------------------
+	 * Each node is allocated in its own cache-aligned storage. The packed arrival word is written by the children and the sense by the wakeup parent, so
+	 * each one takes a whole cache line. The rest of the node is only accessed by its owner.
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the number of threads:
+	 *		barrier::mcs_tree_barrier barrier(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+	 */
+	class mcs_tree_barrier{
+	public:
+		using size_type = unsigned int;
+
+		static const size_type fan_in = 4;
+		static const size_type fan_out = 2;
+
+		// each node is allocated in cache-line boundaries
+		struct node{
+			// where my children signal their arrival: the arrival flags of the (up to) four children packed in a single word
+			std::atomic<std::uint32_t> arrival_children;
+			char _arrival_children_padding[CACHE_LINE_SIZE-sizeof(arrival_children)];
+			// where i expect my wakeup parent to signal me departure
+			std::atomic<bool> sense;
+			char _sense_padding[CACHE_LINE_SIZE-sizeof(sense)];
+			// which children do i have?
+			std::uint32_t arrival_children_mask;
+			// which word and which bit of it should i write upon arrival?
+			std::atomic<std::uint32_t>* arrival_parent;
+			std::uint32_t arrival_bit;
+			// which children must i notify upon departure?
+			std::atomic<bool>* departure_children[fan_out];
+			size_type num_departure_children;
+			bool local_sense; // my local sense value
+		};
+
+		// Initialization is not atomic!
+		explicit mcs_tree_barrier(size_type n) : num_threads{n}{
+			assert(n > 0);
+
+			for (size_type i = 0; i < num_threads; ++i){
+				node* nd = new (barrier::internal::cache_aligned_alloc(sizeof(node))) node();
+
+				nd->arrival_children = 0;
+				nd->sense = false;
+				nd->arrival_parent = nullptr;
+				nd->arrival_bit = 0;
+				nd->num_departure_children = 0;
+				nd->local_sense = true;
+
+				nodes.push_back(nd);
+			}
+
+			for (size_type i = 0; i < num_threads; ++i){
+				// the arrival tree
+				nodes[i]->arrival_children_mask = 0;
+
+				for (size_type c = 0; c < fan_in; ++c){
+					const unsigned long long child = static_cast<unsigned long long>(fan_in)*i + c + 1;
+
+					if (child < num_threads){
+						nodes[i]->arrival_children_mask |= std::uint32_t{1} << c;
+						nodes[child]->arrival_parent = &nodes[i]->arrival_children;
+						nodes[child]->arrival_bit = std::uint32_t{1} << c;
+					}
+				}
+
+				// the departure tree
+				for (size_type c = 0; c < fan_out; ++c){
+					const unsigned long long child = static_cast<unsigned long long>(fan_out)*i + c + 1;
+
+					if (child < num_threads){
+						nodes[i]->departure_children[nodes[i]->num_departure_children++] = &nodes[child]->sense;
+					}
+				}
+			}
+		}
+
+		mcs_tree_barrier(const mcs_tree_barrier&) = delete;
+		mcs_tree_barrier& operator=(const mcs_tree_barrier&) = delete;
+
+		~mcs_tree_barrier(){
+			for (auto nd : nodes){
+				barrier::internal::cache_aligned_free(nd);
+			}
+		}
+
+		void await(size_type id){
+			// relaxed version
+			assert(id < num_threads);
+			node* n = nodes[id];
+
+			// wait until my children have arrived: a single word-compare spin
+			const std::uint32_t expected = n->local_sense ? n->arrival_children_mask : 0;
+
+			while ((n->arrival_children.load(std::memory_order_relaxed) & n->arrival_children_mask) != expected){}
+			n->arrival_children.load(std::memory_order_acquire); // sync memory
+
+			// Inform my parent of my subtree's arrival and pass it the memory. My siblings write the same word, so i only flip my bit.
+			if (n->arrival_parent){
+				if (n->local_sense){
+					n->arrival_parent->fetch_or(n->arrival_bit, std::memory_order_release);
+				}
+				else{
+					n->arrival_parent->fetch_and(~n->arrival_bit, std::memory_order_release);
+				}
+
+				// wait now until my wakeup parent signals departure
+				while (n->sense.load(std::memory_order_relaxed) != n->local_sense){}
+				n->sense.load(std::memory_order_acquire); // sync memory
+			}
+
+			// now its time to signal children on the wakeup tree
+			for (size_type c = 0; c < n->num_departure_children; ++c){
+				n->departure_children[c]->store(n->local_sense, std::memory_order_release); // also sync memory
+			}
+
+			n->local_sense = !n->local_sense;
+		}
+
+	private:
+		const size_type num_threads; // how many threads are expected to arrive at the barrier?
+		std::vector<node*> nodes; // nodes[i] is the node of the thread with logical id i
+	};
+
+} // namespace barrier
+
+#endif
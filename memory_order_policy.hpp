@@ -0,0 +1,79 @@
+#ifndef __MEMORY_ORDER_POLICY_HPP_IS_INCLUDED__
+#define __MEMORY_ORDER_POLICY_HPP_IS_INCLUDED__ 1
+
+#include <atomic>
+
+namespace barrier{
+
+	/**
+	 * Memory Order Policies:
+	 * ---------------------
+	 *
+	 * The barriers are templates on a memory order policy so that all the variants i used to switch with #if blocks can be instantiated in the same binary
+	 * and compared side by side. A policy tells await() which memory order to use for each kind of atomic operation:
+	 *	(1) arrive: the read-modify-write on the shared arrival counter (centralized barrier)
+	 *	(2) reset: the store that resets the arrival counter (centralized barrier)
+	 *	(3) signal: the stores that signal arrival to a parent or departure to the waiting threads. These pass the memory to the other threads.
+	 *	(4) spin: the loads inside the spin loops
+	 *	(5) acquire(a): called once a spin loop on a has finished (and by the last arriver on the counter) to synchronize memory with the signalling thread
+	 *	when (3)/(4) alone do not do it.
+	 *
+	 * The policies are:
+	 *	seq_cst_memory_order: every operation is sequentially-consistent (the "seq-cst version").
+	 *	acq_rel_memory_order: the counter update is acq_rel, the spin loads are acquire and the signals are release. No extra operations.
+	 *	relaxed_acquire_load_memory_order: the spin loads are relaxed and one extra acquire load is done after the loop (the "relaxed version"). On other
+	 *	architectures (like PowerPC) this keeps the (expensive) acquire out of the spin loop.
+	 *	relaxed_acquire_fence_memory_order: as above but an acquire fence replaces the extra load, so there are no extra loads at all.
+	 * See the README for the results on the i7.
+	 */
+
+	struct seq_cst_memory_order{
+		static constexpr std::memory_order arrive = std::memory_order_seq_cst;
+		static constexpr std::memory_order reset = std::memory_order_seq_cst;
+		static constexpr std::memory_order signal = std::memory_order_seq_cst;
+		static constexpr std::memory_order spin = std::memory_order_seq_cst;
+
+		template<class T>
+		static void acquire(const std::atomic<T>&){}
+	};
+
+	struct acq_rel_memory_order{
+		static constexpr std::memory_order arrive = std::memory_order_acq_rel;
+		static constexpr std::memory_order reset = std::memory_order_relaxed;
+		static constexpr std::memory_order signal = std::memory_order_release;
+		static constexpr std::memory_order spin = std::memory_order_acquire;
+
+		template<class T>
+		static void acquire(const std::atomic<T>&){}
+	};
+
+	struct relaxed_acquire_load_memory_order{
+		static constexpr std::memory_order arrive = std::memory_order_release;
+		static constexpr std::memory_order reset = std::memory_order_relaxed;
+		static constexpr std::memory_order signal = std::memory_order_release;
+		static constexpr std::memory_order spin = std::memory_order_relaxed;
+
+		template<class T>
+		static void acquire(const std::atomic<T>& a){
+			a.load(std::memory_order_acquire); // sync memory
+		}
+	};
+
+	struct relaxed_acquire_fence_memory_order{
+		static constexpr std::memory_order arrive = std::memory_order_release;
+		static constexpr std::memory_order reset = std::memory_order_relaxed;
+		static constexpr std::memory_order signal = std::memory_order_release;
+		static constexpr std::memory_order spin = std::memory_order_relaxed;
+
+		template<class T>
+		static void acquire(const std::atomic<T>&){
+			std::atomic_thread_fence(std::memory_order_acquire); // sync memory with the value read by the last relaxed load
+		}
+	};
+
+	//! The default memory order policy. This is the version i found best on the i7 (see the README).
+	using default_memory_order = relaxed_acquire_load_memory_order;
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef __NUMA_HIERARCHICAL_BARRIER_HPP_IS_INCLUDED__
+#define __NUMA_HIERARCHICAL_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+#include "memory_order_policy.hpp"
+#include "prefetch_layout_policy.hpp"
+#include "completion_function.hpp"
+#include "topology.hpp"
+#include "affinity.hpp"
+#include "centralized_sense_reversing_barrier.hpp"
+
+namespace barrier{
+
+	/**
+	 * NUMA Hierarchical Barrier:
+	 * -------------------------
+	 *
+	 * On a machine with many sockets every fetch_add on the counter of the centralized barrier crosses the interconnect. Here the threads are grouped by
+	 * socket (the package level of the topology, see topology.hpp) and each group has a centralized sense-reversing barrier of its own, in the memory of its
+	 * socket. The last thread to arrive at a group barrier then arrives at a top barrier, a centralized barrier of the groups, and the departure of the top
+	 * barrier comes back through the sense of each group barrier. Both levels are the existing centralized_sense_reversing_barrier:
+	 *	(1) the group barrier of g has the threads of g and, as its completion function, the arrival of g at the top barrier (top.arrive_and_wait()),
+	 *	(2) the top barrier has one thread per group and the completion function of the client.
+	 * Thus the last thread of a group waits at the top barrier before it flips the sense of its group, and only one thread per socket touches the top
+	 * barrier. With a single socket there is a single group and the top barrier has a single thread, so the barrier is the centralized barrier plus one
+	 * uncontended fetch_add by the last thread.
+	 *
+	 * The group barriers are used through the std::barrier interface (see centralized_sense_reversing_barrier), so there are no participants and the threads
+	 * use the barrier through their logical id (as the static tree layout, the logical id j is assumed to run on the cpu j modulo the number of cpus).
+	 *
+	 * Data packing and alignment requirements:
+	 * ---------------------------------------
+	 * Each group barrier is allocated (to a Layout::block_size boundary) and constructed by a helper thread bound to the first cpu of the group, so that the
+	 * first touch places it in the memory of that socket. The top barrier is allocated by the constructing thread. The barrier object itself only keeps the
+	 * read-only group of each thread and the pointers to the barriers.
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the number of threads:
+	 *		barrier::numa_hierarchical_barrier<> barrier(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+	 */
+	template<class MemoryOrder = default_memory_order, class Layout = default_prefetch_layout, class CompletionFunction = no_completion>
+	class numa_hierarchical_barrier{
+	public:
+		using size_type = unsigned int;
+		using memory_order_policy = MemoryOrder;
+		using layout_policy = Layout;
+
+	private:
+		// the completion function of a group barrier: the last thread of the group arrives at the top barrier
+		struct top_arrival{
+			numa_hierarchical_barrier* owner;
+
+			void operator()() const{
+				owner->top->arrive_and_wait();
+			}
+		};
+
+	public:
+		using group_barrier_type = centralized_sense_reversing_barrier<MemoryOrder, Layout, top_arrival>;
+		using top_barrier_type = centralized_sense_reversing_barrier<MemoryOrder, Layout, CompletionFunction>;
+
+		// Initialization is not atomic!
+		explicit numa_hierarchical_barrier(size_type n, CompletionFunction completion = CompletionFunction())
+			: numa_hierarchical_barrier(barrier::internal::topology(), n, std::move(completion)){}
+
+		//! Groups the threads by the packages of the given topology
+		numa_hierarchical_barrier(const barrier::internal::topology& topo, size_type n, CompletionFunction completion = CompletionFunction())
+			: group_of(n){
+			assert(n > 0);
+
+			// number the packages in the order of their first thread
+			std::map<int, size_type> group_of_package;
+			std::vector<size_type> group_size;
+			std::vector<int> first_cpu;
+
+			for (size_type i = 0; i < n; ++i){
+				const size_type cpu = i % topo.num_cpus();
+				const int package = topo.domain(cpu, barrier::internal::topology::package_level);
+				auto it = group_of_package.find(package);
+
+				if (it == group_of_package.end()){
+					it = group_of_package.insert(std::make_pair(package, static_cast<size_type>(group_size.size()))).first;
+					group_size.push_back(0);
+					first_cpu.push_back(cpu);
+				}
+
+				group_of[i] = it->second;
+				++group_size[it->second];
+			}
+
+			top = new (barrier::internal::cache_aligned_alloc(sizeof(top_barrier_type), Layout::block_size))
+				top_barrier_type(group_size.size(), std::move(completion));
+
+			for (size_type g = 0; g < group_size.size(); ++g){
+				const size_type size = group_size[g];
+				group_barrier_type* group = nullptr;
+
+				auto place = [this, size, &group](){
+					group = new (barrier::internal::cache_aligned_alloc(sizeof(group_barrier_type), Layout::block_size))
+						group_barrier_type(size, top_arrival{this});
+				};
+
+				if (group_size.size() == 1){
+					place(); // a single socket: the memory is local anyway
+				}
+				else{
+					std::thread helper([&place, &first_cpu, g](){
+						try{
+							barrier::internal::affinity()(first_cpu[g], pthread_self());
+						}
+						catch (const std::runtime_error&){
+							// the cpu is not available to us, so the group barrier is placed wherever the helper runs
+						}
+
+						place();
+					});
+					helper.join();
+				}
+
+				groups.push_back(group);
+			}
+		}
+
+		~numa_hierarchical_barrier(){
+			for (auto group : groups){
+				group->~group_barrier_type();
+				barrier::internal::cache_aligned_free(group);
+			}
+
+			top->~top_barrier_type();
+			barrier::internal::cache_aligned_free(top);
+		}
+
+		numa_hierarchical_barrier(const numa_hierarchical_barrier&) = delete;
+		numa_hierarchical_barrier& operator=(const numa_hierarchical_barrier&) = delete;
+
+		void await(size_type id){
+			assert(id < group_of.size());
+			groups[group_of[id]]->arrive_and_wait();
+		}
+
+		size_type num_groups() const{
+			return groups.size();
+		}
+
+	private:
+		// read-only after construction
+		std::vector<size_type> group_of; // group_of[i] is the group of the thread with logical id i
+		std::vector<group_barrier_type*> groups;
+		top_barrier_type* top;
+	};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __PAYLOAD_HPP_IS_INCLUDED__
+#define __PAYLOAD_HPP_IS_INCLUDED__ 1
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "cache_line_size.hpp"
+
+namespace barrier{
+
+namespace internal{
+
+	// Room for a value that a thread passes along with a flag, so that the value travels in the cache line of the flag and costs no extra miss. The flag
+	// (and its padding) take the last 8 bytes of the line. The value is written before the flag is signalled with release and read after the flag has been
+	// seen with acquire, thus it needs no atomics.
+	using payload_storage = std::aligned_storage<CACHE_LINE_SIZE - sizeof(std::uint64_t), alignof(std::uint64_t)>::type;
+
+	template<class T>
+	struct fits_in_payload : std::integral_constant<bool, std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(payload_storage) &&
+								alignof(T) <= alignof(payload_storage)>{};
+
+	template<class T>
+	void store_payload(payload_storage& p, const T& value){
+		std::memcpy(&p, &value, sizeof(T));
+	}
+
+	template<class T>
+	T load_payload(const payload_storage& p){
+		T value;
+		std::memcpy(&value, &p, sizeof(T));
+		return value;
+	}
+
+} // namespace internal
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef __PREFETCH_LAYOUT_POLICY_HPP_IS_INCLUDED__
+#define __PREFETCH_LAYOUT_POLICY_HPP_IS_INCLUDED__ 1
+
+#include <cstddef>
+#include "cache_line_size.hpp"
+
+namespace barrier{
+
+	/**
+	 * Prefetch Layout Policies:
+	 * ------------------------
+	 *
+	 * The centralized sense-reversing barrier keeps its hot fields (the counter and the sense) apart so that the hardware prefetcher does not bring the line of
+	 * one in when the other is accessed. A layout policy tells how far apart:
+	 *	(1) hot_field_distance: the distance in bytes from the start of the counter to the start of the sense
+	 *	(2) block_size: the sense (and num_threads) are padded to this size, and the barrier must be allocated to a boundary of this size
+	 *
+	 * The policies are:
+	 *	prefetch_isolated_layout: puts 192 cache-lines between the counter and the sense, so that no prefetcher (not even the streaming one) reaches the sense.
+	 *	This is the layout i used for the measurements in the README, but it costs more than 12KB per barrier.
+	 *	prefetch_pair_layout: puts the counter and the sense in different PREFETCH_GRANULARITY blocks (the 128-byte adjacent-line pairs of the Intel).
+	 *	The barrier takes 2 such blocks (4 cache-lines), so thousands of barriers can be allocated without polluting the caches and the TLB.
+	 */
+
+	struct prefetch_isolated_layout{
+		static constexpr std::size_t hot_field_distance = (1 + 3*64)*CACHE_LINE_SIZE;
+		static constexpr std::size_t block_size = CACHE_LINE_SIZE;
+	};
+
+	struct prefetch_pair_layout{
+		static constexpr std::size_t hot_field_distance = PREFETCH_GRANULARITY;
+		static constexpr std::size_t block_size = PREFETCH_GRANULARITY;
+	};
+
+	//! The default layout policy. Keeps the layout the measurements in the README were taken with.
+	using default_prefetch_layout = prefetch_isolated_layout;
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef __SHARDED_CENTRALIZED_SENSE_REVERSING_BARRIER_HPP_IS_INCLUDED__
+#define __SHARDED_CENTRALIZED_SENSE_REVERSING_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <atomic>
+#include <map>
+#include <new>
+#include <utility>
+#include <vector>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+#include "memory_order_policy.hpp"
+#include "prefetch_layout_policy.hpp"
+#include "completion_function.hpp"
+#include "topology.hpp"
+
+namespace barrier{
+
+/**
+ * Sharded Centralized Sense-Reversing Barrier:
+ * -------------------------------------------
+ *
+ * Every arrival at the centralized sense-reversing barrier is a lock xadd on the same counter, thus the arrivals are serialized on the cache line of the
+ * counter and, with many threads, the line travels between the caches once per thread. Here the arrivals are spread over shards, one per domain of the
+ * topology (the L3 by default, see topology.hpp), each with a counter of its own:
+ *	(1) A thread arrives with a fetch_add on the counter of its shard, which only the threads of its domain touch.
+ *	(2) The last thread to arrive at a shard resets the counter of the shard and arrives at the top counter, which thus sees one arrival per shard.
+ *	(3) The last thread to arrive at the top counter resets it, runs the completion function and flips the sense, as in the centralized barrier.
+ * The departure is still the single flip of sense that all the threads spin on. With a single domain there is a single shard and the barrier costs the
+ * centralized barrier plus one uncontended fetch_add by the last thread.
+ *
+ * The threads use the barrier through their logical id, which selects the shard (as the static tree layout, the logical id j is assumed to run on the cpu
+ * j modulo the number of cpus). There are no participants: the token of a thread is read from sense before its arrival, as in the std::barrier interface
+ * of centralized_sense_reversing_barrier (the phase cannot end before my arrival, thus it ends with !sense).
+ *
+ * The memory orders and the completion function are those of the centralized sense-reversing barrier: each counter is synced (MemoryOrder::acquire()) by
+ * the last thread to arrive at it before it arrives at the next level.
+ *
+ * Data packing and alignment requirements:
+ * ---------------------------------------
+ *	The top counter and the sense are laid out by the Layout policy as the counter and the sense of the centralized barrier, and the read-only members
+ *	share the line of the sense. The class is aligned (thus padded) to Layout::block_size and the barrier object must be allocated to a Layout::block_size
+ *	boundary. The shards are allocated by the constructor as an array where each shard is Layout::hot_field_distance bytes apart from the next, so that
+ *	the hardware prefetchers do not pair the counters of two shards.
+ *
+ * Usage:
+ * -----
+ *	Step (a): Allocate and construct the barrier to a Layout::block_size boundary with the number of threads:
+ *		auto barrier = new (barrier::internal::cache_aligned_alloc(sizeof(sharded_centralized_sense_reversing_barrier<>)))
+ *				sharded_centralized_sense_reversing_barrier<>(num_threads);
+ *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+ *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+ */
+template<class MemoryOrder = default_memory_order, class Layout = default_prefetch_layout, class CompletionFunction = no_completion>
+class alignas(Layout::block_size) sharded_centralized_sense_reversing_barrier : private barrier::internal::completion_holder<CompletionFunction>{
+public:
+	using size_type = unsigned int;
+	using memory_order_policy = MemoryOrder;
+	using layout_policy = Layout;
+
+	static_assert(Layout::hot_field_distance % CACHE_LINE_SIZE == 0 && Layout::block_size % CACHE_LINE_SIZE == 0,
+			"the layout must keep the hot fields in different cache-lines");
+
+	// Initialization is not atomic!
+	explicit sharded_centralized_sense_reversing_barrier(size_type n, CompletionFunction completion = CompletionFunction())
+		: sharded_centralized_sense_reversing_barrier(barrier::internal::topology(), n, barrier::internal::topology::l3_level, std::move(completion)){}
+
+	//! One shard per domain of the given level of the given topology
+	sharded_centralized_sense_reversing_barrier(const barrier::internal::topology& topo, size_type n,
+						    barrier::internal::topology::level shard_level = barrier::internal::topology::l3_level,
+						    CompletionFunction completion = CompletionFunction())
+		: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), top_counter{0}, sense{true}, num_shards{0}, shards{nullptr},
+		  shard_of(n){
+		assert(n > 0);
+
+		// number the domains in the order of their first thread
+		std::map<int, size_type> shard_of_domain;
+		std::vector<size_type> shard_size;
+
+		for (size_type i = 0; i < n; ++i){
+			const int domain = topo.domain(i % topo.num_cpus(), shard_level);
+			auto it = shard_of_domain.find(domain);
+
+			if (it == shard_of_domain.end()){
+				it = shard_of_domain.insert(std::make_pair(domain, static_cast<size_type>(shard_size.size()))).first;
+				shard_size.push_back(0);
+			}
+
+			shard_of[i] = it->second;
+			++shard_size[it->second];
+		}
+
+		num_shards = shard_size.size();
+		shards = static_cast<shard*>(barrier::internal::cache_aligned_alloc(num_shards*sizeof(shard), Layout::block_size));
+
+		for (size_type s = 0; s < num_shards; ++s){
+			new (&shards[s]) shard(shard_size[s]);
+		}
+	}
+
+	~sharded_centralized_sense_reversing_barrier(){
+		for (size_type s = 0; s < num_shards; ++s){
+			shards[s].~shard();
+		}
+
+		barrier::internal::cache_aligned_free(shards);
+	}
+
+	sharded_centralized_sense_reversing_barrier(const sharded_centralized_sense_reversing_barrier&) = delete;
+	sharded_centralized_sense_reversing_barrier& operator=(const sharded_centralized_sense_reversing_barrier&) = delete;
+
+	void await(size_type id){
+		assert(id < shard_of.size());
+		shard& s = shards[shard_of[id]];
+
+		// the phase cannot end before my arrival
+		const bool my_sense = !sense.load(std::memory_order_relaxed);
+
+		// arrive at my shard
+		const size_type pre_arrived = s.counter.fetch_add(1, MemoryOrder::arrive);
+
+		if (pre_arrived + 1 == s.num_threads){
+			// i am the last to arrive at my shard so reset it and arrive at the top counter
+			// but first sync memory
+			MemoryOrder::acquire(s.counter);
+			s.counter.store(0, MemoryOrder::reset);
+
+			const size_type pre_arrived_shards = top_counter.fetch_add(1, MemoryOrder::arrive);
+
+			if (pre_arrived_shards + 1 == num_shards){
+				// i am the last to arrive so reset and signal departure
+				// but first sync memory
+				MemoryOrder::acquire(top_counter);
+				top_counter.store(0, MemoryOrder::reset);
+				// run the serial section of the phase before anybody departs
+				this->run_completion();
+				sense.store(my_sense, MemoryOrder::signal);
+				return;
+			}
+		}
+
+		// wait until the last one arrives
+		while (sense.load(MemoryOrder::spin) != my_sense){}
+		MemoryOrder::acquire(sense); // sync memory
+	}
+
+	size_type shard_count() const{
+		return num_shards;
+	}
+
+private:
+	// the arrivals of the threads of a domain
+	struct shard{
+		std::atomic<size_type> counter; // number of threads of the shard that have arrived
+		const size_type num_threads; // how many threads of the shard are expected to arrive
+		char false_sharing_shard_padding[Layout::hot_field_distance - sizeof(counter) - sizeof(num_threads)];
+
+		explicit shard(size_type n) : counter{0}, num_threads{n} {}
+	};
+
+	std::atomic<size_type> top_counter; // number of shards that have arrived
+	// the distance of sense from the top counter is given by the layout policy (see centralized_sense_reversing_barrier)
+	char false_sharing_counter_padding[Layout::hot_field_distance - sizeof(top_counter)];
+
+	std::atomic<bool> sense; // the sense value for the current barrier phase
+	// read-only after construction
+	size_type num_shards;
+	shard* shards;
+	std::vector<size_type> shard_of; // shard_of[i] is the shard of the thread with logical id i
+	// the class is aligned to Layout::block_size, which pads the line of the sense to the end of its block
+};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef __SMT_COMBINING_TREE_BARRIER_HPP_IS_INCLUDED__
+#define __SMT_COMBINING_TREE_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <atomic>
+#include <map>
+#include <new>
+#include <vector>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+#include "topology.hpp"
+#include "static_tree_layout.hpp"
+#include "logical_id_static_tree_barrier.hpp"
+
+namespace barrier{
+
+namespace internal{
+
+	// the shape of the tree of the given members only, renumbered so that the member members[r] is r
+	inline static_tree_shape compact_static_tree_shape(const static_tree_shape& shape, const std::vector<static_tree_shape::size_type>& members){
+		std::vector<static_tree_shape::size_type> rank(shape.children.size());
+
+		for (static_tree_shape::size_type r = 0; r < members.size(); ++r){
+			rank[members[r]] = r;
+		}
+
+		static_tree_shape compact;
+		compact.root = rank[shape.root];
+		compact.children.resize(members.size());
+
+		for (static_tree_shape::size_type r = 0; r < members.size(); ++r){
+			for (auto child : shape.children[members[r]]){
+				compact.children[r].push_back(rank[child]);
+			}
+		}
+
+		return compact;
+	}
+
+} // namespace internal
+
+	/**
+	 * SMT Combining Tree Barrier:
+	 * --------------------------
+	 *
+	 * The static tree layout already combines the SMT siblings first, but each sibling still has a node of its own in the trees, so half of the arrivals and
+	 * departures of a tree on a machine with 2-way SMT are between the threads of a core. This class takes the siblings out of the trees: the threads of a
+	 * core (the core level of the topology) synchronize through a cache line of the core, which stays in the L1 cache they share, and only one of them (the
+	 * representative, the smallest logical id of the core) has a node in the static tree (static_tree_barrier or static_tree_barrier_global_departure):
+	 *	(1) A sibling reads the sense of its core, arrives with a fetch_add on the arrived counter of the core and spins until the sense flips.
+	 *	(2) The representative waits until all its siblings have arrived, resets the counter, uses the tree barrier with its node and then flips the sense
+	 *	of the core, which releases the siblings.
+	 * Thus the trees have one node per core, half the nodes with 2-way SMT, and the first level costs L1 traffic only. A core with a single thread has no
+	 * siblings and its thread uses the tree barrier directly. The completion function of the tree barrier runs after all the threads have arrived, since
+	 * the representatives arrive at the tree only after their siblings.
+	 *
+	 * As the static tree layout, the logical id j is assumed to run on the cpu j modulo the number of cpus (the mapping of the affinity setter). The
+	 * counter and the sense of a core share a cache line on purpose: only the siblings of the core touch it.
+	 *
+	 * Data packing and alignment requirements:
+	 * ---------------------------------------
+	 * The lines of the cores and the nodes of the representatives are cache-aligned and allocated by the constructing thread. The barrier object itself only
+	 * keeps the read-only line and node of each thread, and the tree barrier (aligned as in logical_id_static_tree_barrier).
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the number of threads (and the fans of the trees):
+	 *		barrier::smt_combining_tree_barrier<barrier::static_tree_barrier<> > barrier(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+	 */
+	template<class TreeBarrier>
+	class smt_combining_tree_barrier{
+	public:
+		using size_type = unsigned int;
+		using tree_barrier_type = TreeBarrier;
+		using node_type = typename TreeBarrier::node;
+		using memory_order_policy = typename TreeBarrier::memory_order_policy;
+
+		// Initialization is not atomic!
+		explicit smt_combining_tree_barrier(size_type n, size_type fan_in = 2, size_type fan_out = 2)
+			: smt_combining_tree_barrier(barrier::internal::topology(), n, fan_in, fan_out){}
+
+		//! Groups the threads by the cores of the given topology
+		smt_combining_tree_barrier(const barrier::internal::topology& topo, size_type n, size_type fan_in = 2, size_type fan_out = 2) : threads(n){
+			assert(n > 0);
+
+			std::map<int, core_line*> line_of_core;
+			std::vector<size_type> representatives;
+
+			for (size_type i = 0; i < n; ++i){
+				const int core = topo.domain(i % topo.num_cpus(), barrier::internal::topology::core_level);
+				auto it = line_of_core.find(core);
+
+				if (it == line_of_core.end()){
+					// i am the first thread of the core, thus its representative
+					core_line* line = new (barrier::internal::cache_aligned_alloc(sizeof(core_line))) core_line();
+					lines.push_back(line);
+					line_of_core[core] = line;
+
+					node_type* representative = new (barrier::internal::cache_aligned_alloc(sizeof(node_type))) node_type();
+					representative->local_sense = false;
+					nodes.push_back(representative);
+					representatives.push_back(i);
+
+					threads[i] = thread{line, representative};
+				}
+				else{
+					++it->second->num_siblings;
+					threads[i] = thread{it->second, nullptr};
+				}
+			}
+
+			// the trees of the representatives, placed by their logical ids
+			wire_arrival_tree(nodes, barrier::internal::compact_static_tree_shape(make_static_tree_shape(topo, representatives, n, fan_in), representatives));
+			barrier::internal::wire_departure_tree_if_any(nodes,
+				barrier::internal::compact_static_tree_shape(make_static_tree_shape(topo, representatives, n, fan_out), representatives), 0);
+		}
+
+		~smt_combining_tree_barrier(){
+			for (auto n : nodes){
+				n->~node_type();
+				barrier::internal::cache_aligned_free(n);
+			}
+
+			for (auto line : lines){
+				line->~core_line();
+				barrier::internal::cache_aligned_free(line);
+			}
+		}
+
+		smt_combining_tree_barrier(const smt_combining_tree_barrier&) = delete;
+		smt_combining_tree_barrier& operator=(const smt_combining_tree_barrier&) = delete;
+
+		void await(size_type id){
+			assert(id < threads.size());
+			const thread& t = threads[id];
+			core_line* line = t.line;
+
+			if (t.node == nullptr){
+				// i am a sibling: the sense cannot flip before my arrival
+				const bool my_sense = !line->sense.load(std::memory_order_relaxed);
+
+				line->arrived.fetch_add(1, memory_order_policy::arrive);
+
+				// wait for the representative to signal departure
+				while (line->sense.load(memory_order_policy::spin) != my_sense){}
+				memory_order_policy::acquire(line->sense); // sync memory
+
+				return;
+			}
+
+			if (line->num_siblings == 0){
+				tree.await(t.node);
+				return;
+			}
+
+			// i am the representative: wait for my siblings
+			while (line->arrived.load(memory_order_policy::spin) != line->num_siblings){}
+			memory_order_policy::acquire(line->arrived); // sync memory
+			line->arrived.store(0, memory_order_policy::reset);
+
+			tree.await(t.node);
+
+			// only i write the sense of the core
+			line->sense.store(!line->sense.load(std::memory_order_relaxed), memory_order_policy::signal);
+		}
+
+		size_type num_representatives() const{
+			return nodes.size();
+		}
+
+		TreeBarrier& tree_barrier(){
+			return tree;
+		}
+
+	private:
+		// the synchronization of the threads of a core, in a cache line they share (aligned, thus padded, to it)
+		struct alignas(CACHE_LINE_SIZE) core_line{
+			std::atomic<size_type> arrived; // how many siblings have arrived
+			std::atomic<bool> sense; // flipped by the representative at the departure
+			size_type num_siblings; // the threads of the core other than the representative (read-only after construction)
+
+			core_line() : arrived{0}, sense{false}, num_siblings{0} {}
+		};
+
+		struct thread{
+			core_line* line;
+			node_type* node; // nullptr for the siblings
+		};
+
+		// read-only after construction
+		std::vector<thread> threads; // threads[i] is the thread with logical id i
+		std::vector<core_line*> lines;
+		std::vector<node_type*> nodes; // the nodes of the representatives, in the order of their logical ids
+		alignas(CACHE_LINE_SIZE) TreeBarrier tree; // the global departure barrier writes its sense here
+	};
+
+} // namespace barrier
+
+#endif
@@ -2,9 +2,16 @@
 #define __STATIC_TREE_BARRIER_HPP_IS_INCLUDED__ 1
 
 #include <cassert>
-#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
 #include <atomic>
 #include "cache_line_size.hpp"
+#include "memory_order_policy.hpp"
+#include "payload.hpp"
+#include "array_reduction.hpp"
+#include "completion_function.hpp"
 
 namespace barrier{
 
@@ -19,13 +26,13 @@ namespace barrier{
 	 * Each thread has the following data:
 	 *	(1) Which parent should i notify upon my arrival? atomic_bool* arrival_parent
 	 *	(2) How many children should i expect for the arrival stage and where will they inform me?
-	 *		intmax_t num_arrival_children; 
-	 *		atomic_bool* arrival_children_flag; // array of booleans to be used by my children
+	 *		size_type num_arrival_children; 
+	 *		shared_flag arrival_children_flag[MaxFanIn]; // array of booleans to be used by my children
 	 *	(3) Where should my parent notify me about the departure stage?
 	 *		atomic_bool sense;
 	 *	(4) Which children should i notify for the departure?
-	 *		intmax_t num_departure_children;
-	 *		struct static_tree_barrier_node** departure_children;
+	 *		size_type num_departure_children;
+	 *		node* departure_children[MaxFanOut];
 	 *	(5) Which is my local sense? bool local_sense
 	 *
 	 * Data Packing:
@@ -39,56 +46,110 @@ namespace barrier{
 	 * use that node. Also, avoid having the nodes allocated in an array because a hardware prefetcher may prefetch more cache lines and thus introduce false-sharing.
 	 * Inside each node now i took care not to introduce false-sharing. With the assumption that each node is cache-aligned then the atomic sense value is free of false-sharing.
 	 * The flags, however, arrival_children_flag is another story. Each one must be cache-aligned to avoid false-sharing between the children that are notifying the node of
-	 * their arrival. The implementation uses a struct shared_flag that is padded to a cache line and then allocates an array of those shared_flags. A hardware prefetcher now 
-	 * could be an issue and tests must be made to validate the hypothesis.
+	 * their arrival. The implementation uses a struct shared_flag that is padded to a cache line and keeps an array of MaxFanIn of those shared_flags inline in the node,
+	 * so the flags live in the node's own cache lines and not wherever the heap puts them, and await() does not chase any heap pointer. The departure children are kept
+	 * inline too, in an array of MaxFanOut pointers. Thus the capacities are set at compile time: a node takes MaxFanIn + 2 cache lines (plus the pointers and
+	 * the buffers of the array reduction, if any) and the wiring must not give a node more children than that. A hardware prefetcher now could be an issue and tests must be made to validate the hypothesis.
+	 *
+	 * Memory Ordering:
+	 * ---------------
+	 * The memory orders used by await() are given by the MemoryOrder policy (see memory_order_policy.hpp). The default is the relaxed version.
+	 *
+	 * Completion Function:
+	 * -------------------
+	 * The root runs the CompletionFunction given to the constructor (see completion_function.hpp) once everybody has arrived and before it signals the
+	 * departure, in every kind of episode. The barrier object itself keeps nothing else, so with the default no_completion it is still empty.
+	 *
+	 * Reduction:
+	 * ---------
+	 * await(n, value, op) is a barrier and an all-reduce in the same tree traversal. Each thread combines its value with the partial results of its arrival
+	 * children and passes the result of its subtree to its parent in the line of the parent's flag (see payload.hpp). The root has the result of all the
+	 * threads, and it is passed down the departure tree in the line of each child's sense. Thus every thread returns the same result and the reduction costs
+	 * no extra cache misses. The values are combined in the order of the tree, so op must be associative and commutative (e.g. sum, max, logical and). T
+	 * must be trivially copyable and fit in the payload (56 bytes).
+	 *
+	 * Array Reduction:
+	 * ---------------
+	 * await(n, input, length, op) reduces arrays (e.g. histograms) element by element. Each node keeps two cache-aligned buffers of ReductionBufferSize
+	 * bytes (a template parameter, 0 by default: no array reduction and no buffers), and length elements must fit in one. Each thread copies its input into
+	 * the buffer of its node, so the arrays of the callers are left intact. During the arrival each thread combines the buffers of its arrival children into
+	 * its own buffer with op (array_sum, array_max and array_min of array_reduction.hpp, which use SSE2/AVX for double and float), and passes a pointer to
+	 * its buffer to its parent in the payload. Thus the work is spread over the inner nodes of the tree instead of being done by a single thread after the
+	 * barrier. The root's buffer then holds the result and a pointer to it is passed down the departure tree, so every thread returns a pointer to the
+	 * root's buffer. A node uses its two buffers in alternate episodes, so the root writes the buffer of the result again two episodes later, once every
+	 * thread has arrived at the next one: the result stays readable until the thread arrives at the barrier again.
+	 *
+	 * Scan:
+	 * ----
+	 * arrive_and_scan(n, value) is a barrier that also returns the exclusive prefix sum of the values, the sum of the values of the threads before me. The
+	 * order of the threads is the pre-order of the arrival tree (i before its children, the children in the order they are wired), which is the order of
+	 * the logical ids when the arrival tree is made by make_ordered_static_tree_shape() (with any other tree the offsets are still disjoint and the same in
+	 * every episode). The arrival is that of the reducing await(): each thread passes the sum of its subtree to its parent. The departure goes down the
+	 * arrival tree instead of the departure tree, since only the arrival parent knows where the subtree of a child starts: the parent writes the offset of
+	 * the child's subtree back in the payload of the child's flag and sets the departure_flag of the same line, where the child spins (and then resets it).
 	 *
 	 * Usage:
 	 * -----
+	 *	Step (a): Allocate one cache-aligned node per thread and set sense = true and local_sense = false.
+	 *	Step (b): Wire the nodes into an arrival and a departure tree. static_tree_layout.hpp builds both trees from the topology of the machine for any
+	 *	number of threads: make_static_tree_shape() followed by wire_arrival_tree() and wire_departure_tree().
+	 *	Step (c): Ensure memory visibility of the nodes to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (d): Have each thread use the barrier through await() passing its own node, or through the split-phase arrive() and wait(token).
 	 */
 
-	class static_tree_barrier{
+	template<class MemoryOrder = default_memory_order, unsigned int MaxFanIn = 8, unsigned int MaxFanOut = 8, class CompletionFunction = no_completion,
+		 std::size_t ReductionBufferSize = 0>
+	class static_tree_barrier : private barrier::internal::completion_holder<CompletionFunction>{
 	public:
 		using size_type = unsigned int;
+		using memory_order_policy = MemoryOrder;
+
+		static const size_type max_fan_in = MaxFanIn;
+		static const size_type max_fan_out = MaxFanOut;
 
 		struct shared_flag{
+			barrier::internal::payload_storage payload; // the partial reduction of the child (see the reducing await()) or the offset of its subtree (see arrive_and_scan())
 			std::atomic<bool> flag;
-			char _padding[CACHE_LINE_SIZE-sizeof(flag)];
+			// where the parent signals the departure to the child in arrive_and_scan(). Not sense-reversing (the other episodes do not touch it): the
+			// parent sets it and the child resets it.
+			std::atomic<bool> departure_flag;
+			char _padding[CACHE_LINE_SIZE-sizeof(payload)-sizeof(flag)-sizeof(departure_flag)];
 
 			shared_flag(){
 			 	flag = true;
-			}
-
-			shared_flag(const shared_flag& other){
-				// just do nothing.. this is needed so that i can use the shared_flag in vectors
-				// since atomics have a deleted copy constructor
+				departure_flag = false;
 			}
 		};
  
-		// each node should be allocated in cache-line boundaries
-		struct node{
-			// where i expect my parent to signal me departure
+		// each node should be allocated in cache-line boundaries. The buffers of the array reduction (if any) come first.
+		struct node : barrier::internal::array_reduction_buffers<ReductionBufferSize>{
+			// where i expect my parent to signal me departure (and to pass me the result of the reduction)
+			barrier::internal::payload_storage departure_payload;
 			std::atomic<bool> sense;
-			char _sense_padding[CACHE_LINE_SIZE-sizeof(sense)];
-			// which parent should i notify upon arrival?
-			shared_flag* arrival_parent;
+			char _sense_padding[CACHE_LINE_SIZE-sizeof(departure_payload)-sizeof(sense)];
 			// i need to give each of the children that i expect to arrive one flag
 			// this needs care with hardware prefetchers
-			std::vector<shared_flag> arrival_children_flag; 
+			shared_flag arrival_children_flag[MaxFanIn];
+			size_type num_arrival_children;
+			// which parent should i notify upon arrival?
+			shared_flag* arrival_parent;
 			// which children must i notify upon departure?
-			std::vector<std::atomic<bool>* > departure_children;
+			node* departure_children[MaxFanOut];
+			size_type num_departure_children;
 			bool local_sense; // my local sense value
 			char _local_sense_padding[CACHE_LINE_SIZE-sizeof(local_sense)];
 		};
 
 
-		#if 1
+		explicit static_tree_barrier(CompletionFunction completion = CompletionFunction())
+			: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)){}
+
 		void await(node* n){
-			// relaxed version
 			assert(n != nullptr);
 			// wait until my children have arrived
-			for (auto& flag : n->arrival_children_flag){
-				while (flag.flag.load(std::memory_order_relaxed) != n->local_sense){}
-				flag.flag.load(std::memory_order_acquire); // sync memory
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
 			}
 
 			// note: in the version presented in Shared Memory Synchronization Synthesis Lectures, here the thread re-sets the children flags to true. I instead
@@ -96,51 +157,253 @@ namespace barrier{
 
 			// Inform my parent of my subtree's arrival and pass it the memory
 			if (n->arrival_parent){
-				n->arrival_parent->flag.store(n->local_sense, std::memory_order_release);
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
 
 				// wait now until my parent signals departure
-				while (n->sense.load(std::memory_order_relaxed) != n->local_sense){}
-				n->sense.load(std::memory_order_acquire); // sync memory
+				while (n->sense.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->sense); // sync memory
+			}
+			else{
+				// i am the root and everybody has arrived: run the serial section of the phase before anybody departs
+				this->run_completion();
 			}
 
 			// now its time to signal children on departure tree
-			for (auto sig : n->departure_children){
-				sig->store(n->local_sense, std::memory_order_release); // also sync memory
+			for (size_type c = 0; c < n->num_departure_children; ++c){
+				n->departure_children[c]->sense.store(n->local_sense, MemoryOrder::signal); // also sync memory
 			}
 
 			n->local_sense = !n->local_sense;
 		}
-		#endif
 
-		#if 0
-		void await(node* n){
-			// seq-cst version
+		// The reducing version of await(): returns op applied to the values of all the threads (see the Reduction section).
+		template<class T, class BinaryOp>
+		T await(node* n, T value, BinaryOp op){
+			static_assert(barrier::internal::fits_in_payload<T>::value, "the value must be trivially copyable and fit in the payload");
 			assert(n != nullptr);
-			// wait until my children have arrived
-			for (auto& flag : n->arrival_children_flag){
-				while (flag.flag.load() != n->local_sense){}
+			// wait until my children have arrived and combine their partial results with my value
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+
+				value = op(value, barrier::internal::load_payload<T>(n->arrival_children_flag[c].payload));
 			}
 
-			// note: in the version presented in Shared Memory Synchronization Synthesis Lectures, here the thread re-sets the children flags to true. I instead
-			// use the local sense value to avoid having to perform those stores and reducing perhaps the overall latency for the thread.
+			// Inform my parent of my subtree's arrival and pass it the partial result and the memory
+			if (n->arrival_parent){
+				barrier::internal::store_payload(n->arrival_parent->payload, value);
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
+
+				// wait now until my parent signals departure and passes me the result
+				while (n->sense.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->sense); // sync memory
+
+				value = barrier::internal::load_payload<T>(n->departure_payload);
+			}
+			else{
+				// i am the root and everybody has arrived: run the serial section of the phase before anybody departs
+				this->run_completion();
+			}
+
+			// now its time to pass the result to the children on departure tree
+			for (size_type c = 0; c < n->num_departure_children; ++c){
+				barrier::internal::store_payload(n->departure_children[c]->departure_payload, value);
+				n->departure_children[c]->sense.store(n->local_sense, MemoryOrder::signal); // also sync memory
+			}
+
+			n->local_sense = !n->local_sense;
+
+			return value;
+		}
+
+		// The array reducing version of await(): combines the arrays of all the threads element by element and returns the root's buffer that holds the
+		// result (see the Array Reduction section).
+		template<class T, class ArrayOp>
+		const T* await(node* n, const T* input, std::size_t length, ArrayOp){
+			static_assert(ReductionBufferSize > 0, "the nodes have no buffers for the array reduction (see ReductionBufferSize)");
+			static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= CACHE_LINE_SIZE, "the elements must be trivially copyable");
+			assert(n != nullptr && length*sizeof(T) <= ReductionBufferSize);
+			// the buffer of this episode: the other one may hold the result of the last episode, which the others may still read
+			T* buffer = n->template reduction_buffer<T>(n->local_sense);
+			std::memcpy(buffer, input, length*sizeof(T));
+
+			// wait until my children have arrived and combine their buffers into mine
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+
+				barrier::internal::combine_arrays<T, ArrayOp>(buffer, barrier::internal::load_payload<const T*>(n->arrival_children_flag[c].payload),
+									       length);
+			}
+
+			const T* result = buffer;
+
+			// Inform my parent of my subtree's arrival and pass it my buffer and the memory
+			if (n->arrival_parent){
+				barrier::internal::store_payload(n->arrival_parent->payload, result);
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
+
+				// wait now until my parent signals departure and passes me the root's buffer
+				while (n->sense.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->sense); // sync memory
+
+				result = barrier::internal::load_payload<const T*>(n->departure_payload);
+			}
+			else{
+				// i am the root and everybody has arrived: run the serial section of the phase before anybody departs
+				this->run_completion();
+			}
+
+			// now its time to pass the root's buffer to the children on departure tree
+			for (size_type c = 0; c < n->num_departure_children; ++c){
+				barrier::internal::store_payload(n->departure_children[c]->departure_payload, result);
+				n->departure_children[c]->sense.store(n->local_sense, MemoryOrder::signal); // also sync memory
+			}
+
+			n->local_sense = !n->local_sense;
+
+			return result;
+		}
+
+		// A barrier that returns the sum of the values of the threads before me (see the Scan section)
+		template<class T>
+		T arrive_and_scan(node* n, T value){
+			static_assert(barrier::internal::fits_in_payload<T>::value, "the value must be trivially copyable and fit in the payload");
+			assert(n != nullptr);
+			// wait until my children have arrived and add the sums of their subtrees to my value
+			T subtree_sum = value;
+
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+
+				subtree_sum = subtree_sum + barrier::internal::load_payload<T>(n->arrival_children_flag[c].payload);
+			}
+
+			// the sum of the values before my subtree. Nothing is before the root.
+			T offset = T();
 
-			// Inform my parent of my subtree's arrival and pass it the memory
 			if (n->arrival_parent){
-				n->arrival_parent->flag.store(n->local_sense);
+				// Inform my parent of my subtree's arrival and pass it the sum and the memory
+				barrier::internal::store_payload(n->arrival_parent->payload, subtree_sum);
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
+
+				// wait now until my parent signals departure and passes me the offset of my subtree
+				while (!n->arrival_parent->departure_flag.load(MemoryOrder::spin)){}
+				MemoryOrder::acquire(n->arrival_parent->departure_flag); // sync memory
+
+				offset = barrier::internal::load_payload<T>(n->arrival_parent->payload);
+				// my parent writes it again only after my next arrival
+				n->arrival_parent->departure_flag.store(false, std::memory_order_relaxed);
+
+				// my departure parent has not signalled me, so keep my sense in step for the next await()
+				n->sense.store(n->local_sense, std::memory_order_relaxed);
+			}
+			else{
+				// i am the root and everybody has arrived: run the serial section of the phase before anybody departs
+				this->run_completion();
+			}
+
+			// now its time to pass the offsets to my children: my subtree starts with me and then each child's subtree follows in order
+			T next = offset + value;
+
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				const T child_sum = barrier::internal::load_payload<T>(n->arrival_children_flag[c].payload);
+
+				barrier::internal::store_payload(n->arrival_children_flag[c].payload, next);
+				n->arrival_children_flag[c].departure_flag.store(true, MemoryOrder::signal); // also sync memory
+
+				next = next + child_sum;
+			}
+
+			n->local_sense = !n->local_sense;
+
+			return offset;
+		}
+
+		// the node of the thread and whether the arrival of its subtree has still to be passed to its parent
+		struct arrival_token{
+			node* n;
+			bool pending;
+		};
+
+		// Split-phase version of await(). arrive() never waits for my children: if all of them have arrived already it passes the arrival of my subtree
+		// to my parent (the root signals the departure instead), otherwise the token records that wait() has to do it. wait() completes the arrival if
+		// needed, waits for my parent to signal departure and forwards the departure to my children. Note that my departure children are released only
+		// when i call wait(), thus the work between arrive() and wait() of an inner node delays its subtree. A thread must call wait() before arriving again.
+		arrival_token arrive(node* n){
+			assert(n != nullptr);
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				if (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){
+					return arrival_token{n, true};
+				}
+			}
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+			}
+
+			signal_arrival(n);
+
+			return arrival_token{n, false};
+		}
+
+		void wait(arrival_token token){
+			node* n = token.n;
+			assert(n != nullptr);
+
+			if (token.pending){
+				// wait until my children have arrived
+				for (size_type c = 0; c < n->num_arrival_children; ++c){
+					while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+					MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+				}
+
+				signal_arrival(n);
+			}
 
+			if (n->arrival_parent){
 				// wait now until my parent signals departure
-				while (n->sense.load() != n->local_sense){}
+				while (n->sense.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->sense); // sync memory
+
+				// now its time to signal children on departure tree
+				for (size_type c = 0; c < n->num_departure_children; ++c){
+					n->departure_children[c]->sense.store(n->local_sense, MemoryOrder::signal); // also sync memory
+				}
 			}
 
-			// now its time to signal children on departure tree
-			for (auto sig : n->departure_children){
-				sig->store(n->local_sense); // also sync memory
+			n->local_sense = !n->local_sense;
+		}
+
+		// Arrives without waiting for the departure, for a thread that leaves the trees at this phase (see dynamic_static_tree_barrier). The node must be
+		// taken out of the trees before the departure, usually by the completion function. The root still runs it and signals the departure.
+		void arrive_and_drop(node* n){
+			assert(n != nullptr);
+			// wait until my children have arrived
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
 			}
 
+			signal_arrival(n);
+
 			n->local_sense = !n->local_sense;
 		}
-		#endif
 
+	private:
+		// passes the arrival of my subtree to my parent. The root has nobody to inform, so it signals the departure right away.
+		void signal_arrival(node* n){
+			if (n->arrival_parent){
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
+			}
+			else{
+				this->run_completion(); // everybody has arrived
+
+				for (size_type c = 0; c < n->num_departure_children; ++c){
+					n->departure_children[c]->sense.store(n->local_sense, MemoryOrder::signal); // also sync memory
+				}
+			}
+		}
 	};
 	
 
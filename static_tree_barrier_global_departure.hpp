@@ -2,53 +2,66 @@
 #define __STATIC_TREE_BARRIER_GLOBAL_DEPARTURE_HPP_IS_INCLUDED__
 
 #include <atomic>
+#include <utility>
+#include "memory_order_policy.hpp"
+#include "payload.hpp"
+#include "completion_function.hpp"
 
 /**
  * Static Tree Barrier With Global Departure Flag:
  * -----------------------------------------------
  *
  * This barrier uses the static tree barrier for the arrival part and spinning on a global atomic boolean flag in order to perform the departure stage.
+ * As in the static tree barrier the memory orders are given by the MemoryOrder policy (see memory_order_policy.hpp).
+ *
+ * The reducing await(n, value, op) combines the values up the arrival tree as in the static tree barrier. The root then writes the result next to the
+ * global sense, so the waiting threads read it from the line they spin on.
+ *
+ * The root runs the CompletionFunction (see completion_function.hpp) once everybody has arrived and before it flips the global sense.
  */
 
 namespace barrier{
 
 	// this must be aligned to cache-line boundaries
-	class static_tree_barrier_global_departure{
+	template<class MemoryOrder = default_memory_order, unsigned int MaxFanIn = 8, class CompletionFunction = no_completion>
+	class static_tree_barrier_global_departure : private barrier::internal::completion_holder<CompletionFunction>{
 	public:
 		using size_type = unsigned int;
+		using memory_order_policy = MemoryOrder;
+
+		static const size_type max_fan_in = MaxFanIn;
 
 		struct shared_flag{
+			barrier::internal::payload_storage payload; // the partial reduction of the child (see the reducing await())
 			std::atomic<bool> flag;
-			char _padding[CACHE_LINE_SIZE-sizeof(flag)];
+			char _padding[CACHE_LINE_SIZE-sizeof(payload)-sizeof(flag)];
 
 			shared_flag(){
 			 	flag = true;
 			}
-
-			shared_flag(const shared_flag& other){
-				// just do nothing.. this is needed so that i can use the shared_flag in vectors
-				// since atomics have a deleted copy constructor
-			}
 		};
  
 		// each node should be allocated in cache-line boundaries
 		struct node{
+			// i need to give each of the children that i expect to arrive one flag (inline, see static_tree_barrier)
+			// this needs care with hardware prefetchers
+			shared_flag arrival_children_flag[MaxFanIn];
+			size_type num_arrival_children;
 			// which parent should i notify upon arrival?
 			shared_flag* arrival_parent;
-			// i need to give each of the children that i expect to arrive one flag
-			// this needs care with hardware prefetchers
-			std::vector<shared_flag> arrival_children_flag; 
 			bool local_sense; // my local sense value
 			char _local_sense_padding[CACHE_LINE_SIZE-sizeof(local_sense)];
 		};
 
+		explicit static_tree_barrier_global_departure(CompletionFunction completion = CompletionFunction())
+			: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)){}
+
 		void await(node* n){
-			// relaxed version
 			assert(n != nullptr);
 			// wait until my children have arrived
-			for (auto& flag : n->arrival_children_flag){
-				while (flag.flag.load(std::memory_order_relaxed) != n->local_sense){}
-				flag.flag.load(std::memory_order_acquire); // sync memory
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
 			}
 
 			// note: in the version presented in Shared Memory Synchronization Synthesis Lectures, here the thread re-sets the children flags to true. I instead
@@ -56,23 +69,120 @@ namespace barrier{
 
 			// Inform my parent of my subtree's arrival and pass it the memory
 			if (n->arrival_parent){
-				n->arrival_parent->flag.store(n->local_sense, std::memory_order_release);
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
 
 				// wait now until the root signals departure
-				while (sense.load(std::memory_order_relaxed) != n->local_sense){}
-				sense.load(std::memory_order_acquire); // sync memory
+				while (sense.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(sense); // sync memory
 			}
 			else{
-				// i am the root signal the global departure
-				sense.store(n->local_sense, std::memory_order_release);
+				// i am the root: run the serial section of the phase and signal the global departure
+				this->run_completion();
+				sense.store(n->local_sense, MemoryOrder::signal);
+			}
+
+			n->local_sense = !n->local_sense;
+		}
+
+		// The reducing version of await(): returns op applied to the values of all the threads (see static_tree_barrier)
+		template<class T, class BinaryOp>
+		T await(node* n, T value, BinaryOp op){
+			static_assert(barrier::internal::fits_in_payload<T>::value, "the value must be trivially copyable and fit in the payload");
+			assert(n != nullptr);
+			// wait until my children have arrived and combine their partial results with my value
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+
+				value = op(value, barrier::internal::load_payload<T>(n->arrival_children_flag[c].payload));
+			}
+
+			if (n->arrival_parent){
+				// Inform my parent of my subtree's arrival and pass it the partial result and the memory
+				barrier::internal::store_payload(n->arrival_parent->payload, value);
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
+
+				// wait now until the root signals departure and read the result
+				while (sense.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(sense); // sync memory
+
+				value = barrier::internal::load_payload<T>(result);
+			}
+			else{
+				// i am the root: run the serial section of the phase, publish the result and signal the global departure
+				this->run_completion();
+				barrier::internal::store_payload(result, value);
+				sense.store(n->local_sense, MemoryOrder::signal);
+			}
+
+			n->local_sense = !n->local_sense;
+
+			return value;
+		}
+
+		// the node of the thread and whether the arrival of its subtree has still to be passed to its parent
+		struct arrival_token{
+			node* n;
+			bool pending;
+		};
+
+		// Split-phase version of await(). arrive() never waits for my children: if all of them have arrived already it passes the arrival of my subtree
+		// to my parent (the root signals the global departure instead), otherwise the token records that wait() has to do it. wait() completes the
+		// arrival if needed and waits for the global departure. A thread must call wait() before arriving again.
+		arrival_token arrive(node* n){
+			assert(n != nullptr);
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				if (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){
+					return arrival_token{n, true};
+				}
+			}
+			for (size_type c = 0; c < n->num_arrival_children; ++c){
+				MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+			}
+
+			signal_arrival(n);
+
+			return arrival_token{n, false};
+		}
+
+		void wait(arrival_token token){
+			node* n = token.n;
+			assert(n != nullptr);
+
+			if (token.pending){
+				// wait until my children have arrived
+				for (size_type c = 0; c < n->num_arrival_children; ++c){
+					while (n->arrival_children_flag[c].flag.load(MemoryOrder::spin) != n->local_sense){}
+					MemoryOrder::acquire(n->arrival_children_flag[c].flag); // sync memory
+				}
+
+				signal_arrival(n);
+			}
+
+			if (n->arrival_parent){
+				// wait now until the root signals departure
+				while (sense.load(MemoryOrder::spin) != n->local_sense){}
+				MemoryOrder::acquire(sense); // sync memory
 			}
 
 			n->local_sense = !n->local_sense;
 		}
 		
 	private:
+		// passes the arrival of my subtree to my parent. The root has nobody to inform, so it signals the global departure right away.
+		void signal_arrival(node* n){
+			if (n->arrival_parent){
+				n->arrival_parent->flag.store(n->local_sense, MemoryOrder::signal);
+			}
+			else{
+				this->run_completion(); // everybody has arrived
+				sense.store(n->local_sense, MemoryOrder::signal);
+			}
+		}
+
+		barrier::internal::payload_storage result; // the result of the reduction, written by the root before it signals departure
 		std::atomic<bool> sense{true}; // the global sense value 
-		char _sense_padding[CACHE_LINE_SIZE-sizeof(sense)];
+		char _sense_padding[CACHE_LINE_SIZE-sizeof(result)-sizeof(sense)];
 	};
 	
 
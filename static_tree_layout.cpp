@@ -0,0 +1,148 @@
+#include "static_tree_layout.hpp"
+#include <algorithm>
+#include <deque>
+#include <map>
+
+namespace barrier{
+
+	namespace{
+
+		using size_type = static_tree_shape::size_type;
+
+		// attaches the tree rooted at subtree to the shallowest node of the tree rooted at root that has less than fan children
+		void attach(static_tree_shape& shape, size_type root, size_type subtree, size_type fan){
+			std::deque<size_type> queue{root};
+
+			while (!queue.empty()){
+				const size_type n = queue.front();
+				queue.pop_front();
+
+				if (shape.children[n].size() < fan){
+					shape.children[n].push_back(subtree);
+					return;
+				}
+
+				queue.insert(queue.end(), shape.children[n].begin(), shape.children[n].end());
+			}
+
+			assert(0); // a finite tree always has a leaf
+		}
+
+		// makes the threads first,...,last-1 a tree rooted at first: the rest are split in (at most) fan contiguous ranges, each one a subtree
+		void make_ordered_subtree(static_tree_shape& shape, size_type first, size_type last, size_type fan){
+			const size_type rest = last - first - 1;
+			const size_type num_children = std::min(fan, rest);
+
+			size_type begin = first + 1;
+
+			for (size_type k = 0; k < num_children; ++k){
+				// the first rest % fan ranges take one more thread
+				const size_type end = begin + rest/num_children + ((k < rest % num_children) ? 1 : 0);
+
+				shape.children[first].push_back(begin);
+				make_ordered_subtree(shape, begin, end, fan);
+
+				begin = end;
+			}
+		}
+
+	} // namespace
+
+	static_tree_shape make_static_tree_shape(const barrier::internal::topology& topo, size_type num_threads, size_type fan){
+		assert(num_threads > 0);
+
+		std::vector<size_type> members;
+
+		for (size_type i = 0; i < num_threads; ++i){
+			members.push_back(i);
+		}
+
+		return make_static_tree_shape(topo, members, num_threads, fan);
+	}
+
+	static_tree_shape make_static_tree_shape(const barrier::internal::topology& topo, const std::vector<size_type>& members, size_type num_ids,
+						  size_type fan){
+		assert(!members.empty());
+		assert(fan > 0);
+
+		static_tree_shape shape;
+		shape.children.resize(num_ids);
+
+		// in the beginning each thread is a tree of its own
+		std::vector<size_type> roots(members);
+
+		std::sort(roots.begin(), roots.end());
+		assert(roots.back() < num_ids);
+
+		// combine the trees level by level. The last level is the whole machine.
+		for (int l = 0; l <= barrier::internal::topology::num_levels; ++l){
+			std::map<int, std::vector<size_type> > groups;
+
+			for (auto r : roots){
+				const int domain = (l == barrier::internal::topology::num_levels) ? 0 :
+						   topo.domain(r % topo.num_cpus(), static_cast<barrier::internal::topology::level>(l));
+				groups[domain].push_back(r);
+			}
+
+			roots.clear();
+
+			for (const auto& group : groups){
+				// the roots are in increasing order, so the tree with the smallest root absorbs the others
+				for (std::size_t k = 1; k < group.second.size(); ++k){
+					attach(shape, group.second[0], group.second[k], fan);
+				}
+
+				roots.push_back(group.second[0]);
+			}
+
+			std::sort(roots.begin(), roots.end());
+		}
+
+		assert(roots.size() == 1);
+		shape.root = roots[0];
+
+		return shape;
+	}
+
+	static_tree_shape make_ordered_static_tree_shape(size_type num_threads, size_type fan){
+		assert(num_threads > 0);
+		assert(fan > 0);
+
+		static_tree_shape shape;
+		shape.root = 0;
+		shape.children.resize(num_threads);
+
+		make_ordered_subtree(shape, 0, num_threads, fan);
+
+		return shape;
+	}
+
+	std::vector<size_type> breadth_first_order(const static_tree_shape& shape){
+		std::vector<size_type> order{shape.root};
+
+		// the order is its own queue
+		for (std::size_t k = 0; k < order.size(); ++k){
+			const auto& children = shape.children[order[k]];
+			order.insert(order.end(), children.begin(), children.end());
+		}
+
+		return order;
+	}
+
+	static_tree_shape relabel_static_tree_shape(const static_tree_shape& shape, const std::vector<size_type>& thread_at){
+		assert(thread_at.size() == shape.children.size());
+
+		static_tree_shape relabeled;
+		relabeled.root = thread_at[shape.root];
+		relabeled.children.resize(shape.children.size());
+
+		for (size_type p = 0; p < shape.children.size(); ++p){
+			for (auto child : shape.children[p]){
+				relabeled.children[thread_at[p]].push_back(thread_at[child]);
+			}
+		}
+
+		return relabeled;
+	}
+
+} // namespace barrier
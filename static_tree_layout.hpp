@@ -0,0 +1,123 @@
+#ifndef __STATIC_TREE_LAYOUT_HPP_IS_INCLUDED__
+#define __STATIC_TREE_LAYOUT_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <vector>
+#include <type_traits>
+#include "topology.hpp"
+
+namespace barrier{
+
+	/**
+	 * Static Tree Layout:
+	 * ------------------
+	 *
+	 * Builds the shape of the arrival and departure trees of the static tree barriers from the topology of the machine, for any number of threads.
+	 * The thread with logical id j is assumed to run on the cpu j (modulo the number of cpus), which is the mapping of the affinity setter.
+	 *
+	 * The tree is built bottom-up following the levels of the topology. In the beginning each thread is a tree of its own. Then at each level (SMT siblings,
+	 * shared L2, shared L3, socket and finally the whole machine) the trees whose roots are in the same domain are combined: the tree with the smallest root
+	 * absorbs the others, each one attached to the shallowest node that still has less than fan children. Thus the SMT siblings combine first, then the
+	 * cores that share an L2/L3, then the sockets, every node has at most fan children, and the root is always the thread 0.
+	 *
+	 * The fan is a runtime parameter, so the arrival tree (fan-in) and the departure tree (fan-out) of a static_tree_barrier can have different shapes:
+	 * build one shape per tree. Since both trees are rooted at the thread 0 they can always be combined.
+	 */
+	struct static_tree_shape{
+		using size_type = unsigned int;
+
+		size_type root;
+		std::vector<std::vector<size_type> > children; // children[i] are the children of the thread with logical id i (in the order they are wired)
+	};
+
+	/**
+	 * Makes a tree shape for the given number of threads.
+	 *
+	 * \param topo The topology of the machine
+	 * \param num_threads The number of threads
+	 * \param fan The maximum number of children of each node
+	 */
+	static_tree_shape make_static_tree_shape(const barrier::internal::topology& topo, static_tree_shape::size_type num_threads,
+						  static_tree_shape::size_type fan);
+
+	/**
+	 * Makes a tree shape for the given members only (for the barriers whose threads come and go, see dynamic_static_tree_barrier). The ids are the logical
+	 * ids of the threads, so a member is placed by the topology exactly as in a tree of all the threads. The other ids have no children and are in no
+	 * tree, and the root is the smallest member.
+	 *
+	 * \param topo The topology of the machine
+	 * \param members The logical ids of the members (at least one)
+	 * \param num_ids The number of logical ids, all the members are less than it (the size of the children vector)
+	 * \param fan The maximum number of children of each node
+	 */
+	static_tree_shape make_static_tree_shape(const barrier::internal::topology& topo, const std::vector<static_tree_shape::size_type>& members,
+						  static_tree_shape::size_type num_ids, static_tree_shape::size_type fan);
+
+	/**
+	 * Makes a tree shape whose pre-order (a node before its children, the children in the order they are wired) is the order of the logical ids, so that
+	 * every subtree is a contiguous range of ids. This is the arrival tree arrive_and_scan() of static_tree_barrier needs to return the prefix in the order
+	 * of the logical ids. It does not follow the topology, but with the affinity setter neighbouring ids run on neighbouring cpus.
+	 *
+	 * \param num_threads The number of threads
+	 * \param fan The maximum number of children of each node
+	 */
+	static_tree_shape make_ordered_static_tree_shape(static_tree_shape::size_type num_threads, static_tree_shape::size_type fan);
+
+	/**
+	 * The nodes of the given shape in breadth-first order from the root (the children in the order they are wired), that is from the shallowest to the
+	 * deepest: the first is the root and the leaves come last.
+	 *
+	 * \param shape The shape of a tree of all its ids
+	 */
+	std::vector<static_tree_shape::size_type> breadth_first_order(const static_tree_shape& shape);
+
+	/**
+	 * Moves the threads to other places of the same tree: the thread thread_at[p] takes the place of the id p of the given shape, with its parent and its
+	 * children. Thus the trees keep their shapes while the threads change places (see straggler_aware_static_tree_barrier).
+	 *
+	 * \param shape The shape of a tree of all its ids
+	 * \param thread_at A permutation of the ids: the thread at each place
+	 */
+	static_tree_shape relabel_static_tree_shape(const static_tree_shape& shape, const std::vector<static_tree_shape::size_type>& thread_at);
+
+	/**
+	 * Wires the arrival tree of the given nodes (nodes[i] is the node for the thread with logical id i) according to the given shape.
+	 * Works for the nodes of both static_tree_barrier and static_tree_barrier_global_departure. The nodes keep their children inline, so no node may have
+	 * more children than the capacity of its arrival_children_flag array (the MaxFanIn of the barrier).
+	 */
+	template<class Node>
+	void wire_arrival_tree(const std::vector<Node*>& nodes, const static_tree_shape& shape){
+		assert(nodes.size() == shape.children.size());
+
+		nodes[shape.root]->arrival_parent = nullptr;
+
+		for (std::size_t i = 0; i < nodes.size(); ++i){
+			assert(shape.children[i].size() <= std::extent<decltype(nodes[i]->arrival_children_flag)>::value);
+			nodes[i]->num_arrival_children = shape.children[i].size();
+
+			for (std::size_t k = 0; k < shape.children[i].size(); ++k){
+				nodes[i]->arrival_children_flag[k].flag = true;
+				nodes[shape.children[i][k]]->arrival_parent = &nodes[i]->arrival_children_flag[k];
+			}
+		}
+	}
+
+	//! Wires the departure tree of the given nodes according to the given shape (must have the same root as the arrival tree). No node may have more children
+	//! than the capacity of its departure_children array (the MaxFanOut of the barrier).
+	template<class Node>
+	void wire_departure_tree(const std::vector<Node*>& nodes, const static_tree_shape& shape){
+		assert(nodes.size() == shape.children.size());
+
+		for (std::size_t i = 0; i < nodes.size(); ++i){
+			assert(shape.children[i].size() <= std::extent<decltype(nodes[i]->departure_children)>::value);
+			nodes[i]->num_departure_children = shape.children[i].size();
+
+			for (std::size_t k = 0; k < shape.children[i].size(); ++k){
+				nodes[i]->departure_children[k] = nodes[shape.children[i][k]];
+			}
+		}
+	}
+
+} // namespace barrier
+
+#endif
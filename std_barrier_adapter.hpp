@@ -0,0 +1,185 @@
+#ifndef __STD_BARRIER_ADAPTER_HPP_IS_INCLUDED__
+#define __STD_BARRIER_ADAPTER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace barrier{
+
+namespace internal{
+
+	// the token of the algorithms without a split-phase arrival: arrive() has already waited for the phase to complete
+	struct blocking_arrival{};
+
+	// the split-phase arrival of the barriers that have one (logical_id_static_tree_barrier), chosen by overloading on whether arrive(id) exists
+	template<class Barrier>
+	auto split_phase_arrive(Barrier& b, unsigned int id, int) -> decltype(b.arrive(id)){
+		return b.arrive(id);
+	}
+
+	// the dissemination, tournament and MCS tree barriers only have await()
+	template<class Barrier>
+	blocking_arrival split_phase_arrive(Barrier& b, unsigned int id, long){
+		b.await(id);
+		return blocking_arrival{};
+	}
+
+	template<class Barrier, class Token>
+	void split_phase_wait(Barrier& b, Token token){
+		b.wait(token);
+	}
+
+	template<class Barrier>
+	void split_phase_wait(Barrier&, blocking_arrival){}
+
+	// whether the barrier can lower its number of threads (arrive_and_drop(id))
+	template<class Barrier>
+	auto has_arrive_and_drop(Barrier* b, int) -> decltype(b->arrive_and_drop(0u), std::true_type());
+
+	template<class Barrier>
+	std::false_type has_arrive_and_drop(Barrier*, long);
+
+} // namespace internal
+
+	/**
+	 * std::barrier Adapter:
+	 * --------------------
+	 *
+	 * std::barrier has no per-thread state in its interface: any thread calls arrive_and_wait() and the barrier works out the rest. The centralized barriers
+	 * can do the same and have that interface themselves (arrive_and_wait(), arrive(update), wait(token), arrive_and_drop()). The other algorithms need the
+	 * logical id of the thread, which selects its node, its partners or its place in the tree. This adapter gives them the interface of std::barrier, so that
+	 * the code written for std::barrier can switch algorithm by switching a type:
+	 *	barrier::std_barrier_adapter<barrier::dissemination_barrier<> > barrier(num_threads);
+	 *	barrier::std_barrier_adapter<barrier::logical_id_static_tree_barrier<barrier::static_tree_barrier<> > > barrier(num_threads);
+	 * The wrapped barrier is constructed with the number of threads (and any other arguments given after it) and used through await(id).
+	 *
+	 * Logical ids:
+	 * -----------
+	 * A thread gets its logical id at its first arrival, in the order of the first arrivals (so use the affinity setter in that order). The ids are kept in a
+	 * map from std::thread::id, which is searched under a mutex only at the first arrival of a thread: after that, the thread finds its id in a thread local
+	 * cache of the last adapter it used. Thus each arrival costs one access to a function local thread_local (with a constant initializer, so no TLS wrapper)
+	 * plus a compare with the adapter. A thread that alternates between two adapters goes to the map on every arrival, so keep such threads on the native
+	 * interface of the barriers.
+	 *
+	 * Split-phase arrival:
+	 * -------------------
+	 * arrive() and wait(token) are forwarded to arrive(id) and wait(token) of the wrapped barrier when it has them (logical_id_static_tree_barrier over
+	 * static_tree_barrier or static_tree_barrier_global_departure), so the thread can do work between them that the others wait for, as with std::barrier.
+	 * Note that a tree node whose children have not arrived yet passes the arrival of its subtree on in wait() (see static_tree_barrier), thus the phase
+	 * does not complete before that thread calls wait().
+	 *
+	 * Limitations:
+	 * -----------
+	 *	(1) The dissemination, tournament and MCS tree barriers have no split-phase arrival, thus with them arrive() waits for the phase to complete and
+	 *	wait() returns immediately. Code that does something the others wait for between arrive() and wait() deadlocks with these algorithms.
+	 *	(2) A thread arrives for itself only, so arrive(update) needs update == 1.
+	 *	(3) arrive_and_drop() needs an algorithm that can lower its number of threads, which is only dynamic_static_tree_barrier (the centralized barriers
+	 *	have it natively). The dissemination, tournament and MCS tree barriers, logical_id_static_tree_barrier and the fixed-size barriers fix their
+	 *	partners, trees or sizes at construction and do not support it: arrive_and_drop() fails with a static_assert for them.
+	 */
+	template<class Barrier>
+	class std_barrier_adapter{
+	public:
+		using size_type = unsigned int;
+		using barrier_type = Barrier;
+
+		// the token of the wrapped barrier, or blocking_arrival when the phase is over by the time arrive() returns
+		using arrival_token = decltype(barrier::internal::split_phase_arrive(std::declval<Barrier&>(), 0u, 0));
+
+		// Initialization is not atomic!
+		template<class... Args>
+		explicit std_barrier_adapter(std::ptrdiff_t expected, Args&&... args)
+			: wrapped(static_cast<size_type>(expected), std::forward<Args>(args)...), serial{next_serial()}, num_threads{static_cast<size_type>(expected)} {
+			assert(expected > 0);
+		}
+
+		std_barrier_adapter(const std_barrier_adapter&) = delete;
+		std_barrier_adapter& operator=(const std_barrier_adapter&) = delete;
+
+		static constexpr std::ptrdiff_t max() noexcept{
+			return std::numeric_limits<size_type>::max();
+		}
+
+		arrival_token arrive(std::ptrdiff_t update = 1){
+			assert(update == 1);
+			(void)update;
+
+			return barrier::internal::split_phase_arrive(wrapped, logical_id(), 0);
+		}
+
+		void wait(arrival_token&& token) const{
+			barrier::internal::split_phase_wait(wrapped, std::move(token));
+		}
+
+		void arrive_and_wait(){
+			wrapped.await(logical_id());
+		}
+
+		void arrive_and_drop(){
+			static_assert(decltype(barrier::internal::has_arrive_and_drop(static_cast<Barrier*>(nullptr), 0))::value,
+				      "the wrapped barrier cannot lower its number of threads (see the limitations of std_barrier_adapter)");
+			wrapped.arrive_and_drop(logical_id());
+		}
+
+		Barrier& wrapped_barrier(){
+			return wrapped;
+		}
+
+	private:
+		// tells apart an adapter from one constructed later at the same address
+		static std::uint64_t next_serial(){
+			static std::atomic<std::uint64_t> next{1};
+			return next.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		size_type logical_id(){
+			struct binding{
+				const std_barrier_adapter* adapter;
+				std::uint64_t serial;
+				size_type id;
+			};
+
+			static thread_local binding last{nullptr, 0, 0};
+
+			if (last.adapter == this && last.serial == serial){
+				return last.id;
+			}
+
+			size_type id;
+			{
+				std::lock_guard<std::mutex> lock(ids_mutex);
+				auto it = ids.find(std::this_thread::get_id());
+
+				if (it == ids.end()){
+					assert(ids.size() < num_threads);
+					id = ids.size();
+					ids.emplace(std::this_thread::get_id(), id);
+				}
+				else{
+					id = it->second;
+				}
+			}
+
+			last = binding{this, serial, id};
+			return id;
+		}
+
+		mutable Barrier wrapped; // mutable since wait() is const in std::barrier
+		const std::uint64_t serial; // read-only, like the members of the wrapped barriers
+		const size_type num_threads;
+		// touched only at the first arrival of each thread
+		std::mutex ids_mutex;
+		std::map<std::thread::id, size_type> ids;
+	};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef __STRAGGLER_AWARE_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__
+#define __STRAGGLER_AWARE_STATIC_TREE_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+#include "memory_order_policy.hpp"
+#include "completion_function.hpp"
+#include "tsc.hpp"
+#include "topology.hpp"
+#include "static_tree_layout.hpp"
+#include "static_tree_barrier.hpp"
+#include "logical_id_static_tree_barrier.hpp"
+
+namespace barrier{
+
+	/**
+	 * Straggler-Aware Static Tree Barrier:
+	 * -----------------------------------
+	 *
+	 * In the static tree barrier a node passes the arrival of its subtree to its parent only once all its children have arrived, so a thread that is late
+	 * at a deep node adds the latency of the path to the root to its lateness. When the same threads are late phase after phase, they are better placed near
+	 * the root (the latest one at the root, which starts the departure as soon as it arrives) and the early ones at the leaves, where their arrivals have
+	 * the whole path to propagate while the late ones are still working. This barrier keeps the shapes of the trees built from the topology (see
+	 * static_tree_layout.hpp) and moves the threads between their places:
+	 *	(1) Sampling: one phase every sample_period is sampled. In a sampled phase each thread reads the time stamp counter (tsc.hpp) before its arrival,
+	 *	into a slot of its own, and the root reads the slots in its completion step (the arrivals publish them). The lateness of a thread is the time from
+	 *	the first arrival to its own, and each thread keeps a moving average of it (weight 1/8). The root also keeps a moving average of the arrival cost,
+	 *	the time from the last arrival to its completion step (how long an arrival takes to reach the root).
+	 *	(2) Reshaping: every reshape_period samples the root orders the threads from the latest to the earliest and gives them the places of the trees in
+	 *	breadth-first order (breadth_first_order() of the arrival tree), then rewires the nodes with wire_arrival_tree() and wire_departure_tree() of the
+	 *	relabeled shapes (relabel_static_tree_shape()). The order starts from the current places (shallowest first) and a thread only moves ahead of
+	 *	another one when it is later by more than the arrival cost (the hysteresis): a smaller gap is hidden by the arrival path anyway. Nothing changes
+	 *	when the order of the places does not.
+	 * The rewiring is that of dynamic_static_tree_barrier: it runs at the phase boundary, after everybody has arrived and before anybody departs, thus
+	 * nobody reads the wiring, and the departure publishes it. When the root changes, the repair signals the departure to the new root (the departure tree
+	 * of the old root no longer reaches it) and gives the old root the sense of the phase (the root never waits on its sense).
+	 *
+	 * The threads move away from the cpus their places were laid out for, so the trees lose locality in exchange for the shorter critical path. In a
+	 * balanced run the averages of the threads differ by noise, which is less than the arrival cost, so the threads keep their places.
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the number of threads (and the fans, how often to sample and how often to reshape):
+	 *		barrier::straggler_aware_static_tree_barrier<> barrier(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+	 */
+	template<class MemoryOrder = default_memory_order, unsigned int MaxFanIn = 8, unsigned int MaxFanOut = 8, class CompletionFunction = no_completion>
+	class straggler_aware_static_tree_barrier : private barrier::internal::completion_holder<CompletionFunction>{
+	public:
+		using size_type = unsigned int;
+		using memory_order_policy = MemoryOrder;
+
+	private:
+		// the completion function of the tree: samples, reshapes and then runs the completion function of the client
+		struct reshape_step{
+			straggler_aware_static_tree_barrier* owner;
+
+			void operator()() const{
+				owner->complete_phase();
+			}
+		};
+
+	public:
+		using tree_barrier_type = logical_id_static_tree_barrier<static_tree_barrier<MemoryOrder, MaxFanIn, MaxFanOut, reshape_step> >;
+		using node = typename tree_barrier_type::node_type;
+
+		// Initialization is not atomic!
+		explicit straggler_aware_static_tree_barrier(size_type n, size_type fan_in = 2, size_type fan_out = 2, size_type sample_period = 16,
+							     size_type reshape_period = 8, CompletionFunction completion = CompletionFunction())
+			: barrier::internal::completion_holder<CompletionFunction>(std::move(completion)), tree(n, fan_in, fan_out, reshape_step{this}),
+			  sampling{false}, num_threads{n}, sample_period{sample_period}, reshape_period{reshape_period}, phase{0}, samples_taken{0},
+			  nodes(n), thread_at(n), lateness(n, 0), arrival_cost{0}{
+			assert(n > 0 && sample_period > 0 && reshape_period > 0);
+
+			// the places, as wired by tree: the thread i is at the place i
+			barrier::internal::topology topo;
+			arrival_places = make_static_tree_shape(topo, n, fan_in);
+			departure_places = make_static_tree_shape(topo, n, fan_out);
+			places_by_depth = breadth_first_order(arrival_places);
+
+			for (size_type i = 0; i < n; ++i){
+				nodes[i] = tree.node(i);
+				thread_at[i] = i;
+			}
+
+			stamps = static_cast<stamp*>(barrier::internal::cache_aligned_alloc(n*sizeof(stamp), PREFETCH_GRANULARITY));
+			for (size_type i = 0; i < n; ++i){
+				new (&stamps[i]) stamp();
+			}
+		}
+
+		~straggler_aware_static_tree_barrier(){
+			barrier::internal::cache_aligned_free(stamps);
+		}
+
+		straggler_aware_static_tree_barrier(const straggler_aware_static_tree_barrier&) = delete;
+		straggler_aware_static_tree_barrier& operator=(const straggler_aware_static_tree_barrier&) = delete;
+
+		void await(size_type id){
+			assert(id < num_threads);
+
+			if (sampling){
+				// published to the root by my arrival
+				stamps[id].arrival = barrier::internal::read_tsc();
+			}
+
+			tree.await(id);
+		}
+
+		//! The logical id of the thread at the root of the trees (only meaningful between the phases)
+		size_type root() const{
+			return thread_at[arrival_places.root];
+		}
+
+	private:
+		// run by the root after everybody has arrived
+		void complete_phase(){
+			if (sampling){
+				sample();
+
+				if (++samples_taken == reshape_period){
+					samples_taken = 0;
+					reshape();
+				}
+			}
+
+			phase = (phase + 1) % sample_period;
+			sampling = (phase == 0);
+
+			this->run_completion();
+		}
+
+		void sample(){
+			const std::uint64_t now = barrier::internal::read_tsc();
+			std::uint64_t first_arrival = std::numeric_limits<std::uint64_t>::max(), last_arrival = 0;
+
+			for (size_type i = 0; i < num_threads; ++i){
+				first_arrival = std::min(first_arrival, stamps[i].arrival);
+				last_arrival = std::max(last_arrival, stamps[i].arrival);
+			}
+
+			arrival_cost = arrival_cost - arrival_cost/8 + ((now > last_arrival) ? now - last_arrival : 0)/8;
+
+			for (size_type i = 0; i < num_threads; ++i){
+				lateness[i] = lateness[i] - lateness[i]/8 + (stamps[i].arrival - first_arrival)/8;
+			}
+		}
+
+		void reshape(){
+			// the threads in the order of their current places, from the shallowest to the deepest
+			std::vector<size_type> by_lateness(num_threads);
+
+			for (size_type k = 0; k < num_threads; ++k){
+				by_lateness[k] = thread_at[places_by_depth[k]];
+			}
+
+			// insertion sort, where a thread moves ahead of another one only when it is later by more than the arrival cost. The gap is not a strict
+			// weak ordering, so std::sort would not do.
+			for (size_type k = 1; k < num_threads; ++k){
+				const size_type t = by_lateness[k];
+				size_type j = k;
+
+				for (; j > 0 && lateness[t] > lateness[by_lateness[j-1]] + arrival_cost; --j){
+					by_lateness[j] = by_lateness[j-1];
+				}
+
+				by_lateness[j] = t;
+			}
+
+			// the latest thread takes the root, the next ones the shallowest places and the earliest ones the leaves
+			std::vector<size_type> next(num_threads);
+
+			for (size_type k = 0; k < num_threads; ++k){
+				next[places_by_depth[k]] = by_lateness[k];
+			}
+
+			if (next == thread_at){
+				return;
+			}
+
+			const size_type old_root = root();
+			const bool phase_sense = nodes[old_root]->local_sense; // the sense of the phase that ends now
+
+			thread_at = std::move(next);
+
+			wire_arrival_tree(nodes, relabel_static_tree_shape(arrival_places, thread_at));
+			wire_departure_tree(nodes, relabel_static_tree_shape(departure_places, thread_at));
+
+			// everybody has arrived at this phase, thus every flag is free: not arrived at the next phase
+			for (auto n : nodes){
+				for (size_type k = 0; k < n->num_arrival_children; ++k){
+					n->arrival_children_flag[k].flag.store(phase_sense, std::memory_order_relaxed);
+				}
+			}
+
+			const size_type new_root = root();
+
+			if (new_root != old_root){
+				// the root never waits on its sense, so it may be that of the next phase. Now the old root will wait on it.
+				nodes[old_root]->sense.store(phase_sense, std::memory_order_relaxed);
+
+				// the departure tree of the old root does not reach the new root
+				nodes[new_root]->sense.store(phase_sense, MemoryOrder::signal); // also sync memory
+			}
+		}
+
+		// the time stamp of a thread in the last sampled phase
+		struct stamp{
+			std::uint64_t arrival;
+			char _padding[PREFETCH_GRANULARITY-sizeof(arrival)];
+
+			stamp() : arrival{0} {}
+		};
+
+		tree_barrier_type tree;
+
+		// read by every thread at every phase, written only at the phase boundaries
+		alignas(CACHE_LINE_SIZE) bool sampling;
+		const size_type num_threads;
+		stamp* stamps;
+
+		// accessed only at the phase boundaries
+		alignas(CACHE_LINE_SIZE) const size_type sample_period;
+		const size_type reshape_period;
+		size_type phase; // the phase modulo sample_period
+		size_type samples_taken; // since the last reshaping
+		std::vector<node*> nodes; // nodes[i] is the node of the thread with logical id i
+		std::vector<size_type> thread_at; // thread_at[p] is the thread at the place p
+		std::vector<std::uint64_t> lateness; // the moving average of the lateness of each thread
+		std::uint64_t arrival_cost; // the moving average of the time from the last arrival to the completion step
+		static_tree_shape arrival_places;
+		static_tree_shape departure_places;
+		std::vector<size_type> places_by_depth; // the places of the arrival tree in breadth-first order
+	};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,98 @@
+#include "topology.hpp"
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace barrier{
+
+namespace internal{
+
+	namespace{
+
+		// sysfs cpu lists (such as "0-3,8-11") are sorted, thus the first cpu of the list is the smallest one. Returns -1 if the file cannot be read.
+		int read_first_cpu_of_list(const std::string& path){
+			std::ifstream in(path);
+			int cpu = -1;
+
+			if (!(in >> cpu)){
+				return -1;
+			}
+
+			return cpu;
+		}
+
+		std::string read_word(const std::string& path){
+			std::ifstream in(path);
+			std::string word;
+
+			in >> word;
+
+			return word;
+		}
+
+		// the domain of the cache of the given level that holds data (unified or data cache), or -1 if there is no such cache
+		int read_cache_domain(const std::string& cpu_path, int cache_level){
+			for (int index = 0; ; ++index){
+				std::ostringstream index_path;
+				index_path << cpu_path << "/cache/index" << index;
+
+				std::ifstream level_file(index_path.str() + "/level");
+				int level = 0;
+
+				if (!(level_file >> level)){
+					return -1; // no more caches
+				}
+
+				const std::string type = read_word(index_path.str() + "/type");
+
+				if (level == cache_level && type != "Instruction"){
+					return read_first_cpu_of_list(index_path.str() + "/shared_cpu_list");
+				}
+			}
+		}
+
+	} // namespace
+
+	topology::topology(){
+		unsigned int hardware_threads = std::thread::hardware_concurrency();
+
+		if (hardware_threads == 0){
+			hardware_threads = 1;
+		}
+
+		for (unsigned int i = 0; i < hardware_threads; ++i){
+			std::ostringstream cpu_path;
+			cpu_path << "/sys/devices/system/cpu/cpu" << i;
+
+			const int cpu = static_cast<int>(i);
+			cpu_info info;
+
+			info.domain[core_level] = read_first_cpu_of_list(cpu_path.str() + "/topology/thread_siblings_list");
+			info.domain[l2_level] = read_cache_domain(cpu_path.str(), 2);
+			info.domain[l3_level] = read_cache_domain(cpu_path.str(), 3);
+			info.domain[package_level] = read_first_cpu_of_list(cpu_path.str() + "/topology/core_siblings_list");
+
+			// fill in whatever is missing
+			for (int l = core_level; l < package_level; ++l){
+				if (info.domain[l] < 0){
+					info.domain[l] = cpu;
+				}
+			}
+			if (info.domain[package_level] < 0){
+				info.domain[package_level] = 0;
+			}
+
+			cpus.push_back(info);
+		}
+	}
+
+	topology::topology(std::vector<cpu_info> cpus) : cpus(std::move(cpus)){
+		assert(!this->cpus.empty());
+	}
+
+} // namespace internal
+
+} // namespace barrier
@@ -0,0 +1,57 @@
+#ifndef __TOPOLOGY_HPP_IS_INCLUDED__
+#define __TOPOLOGY_HPP_IS_INCLUDED__ 1
+
+#include <vector>
+
+namespace barrier{
+
+namespace internal{
+
+	/**
+	 * The topology of the machine as exported by the Linux kernel under /sys/devices/system/cpu.
+	 *
+	 * For each cpu i keep the domain it belongs to at every level of the memory hierarchy, from the innermost to the outermost:
+	 *	(1) core_level: the SMT siblings that share the core (topology/thread_siblings_list)
+	 *	(2) l2_level: the cpus that share the L2 cache (cache/indexN/shared_cpu_list of the level 2 cache)
+	 *	(3) l3_level: the cpus that share the L3 cache (cache/indexN/shared_cpu_list of the level 3 cache)
+	 *	(4) package_level: the cpus of the same socket (topology/core_siblings_list)
+	 * A domain is identified by the smallest cpu it contains, thus two cpus are in the same domain at some level iff they have the same identifier at that
+	 * level. When some information is not available (for example there is no L3 cache or no sysfs at all) the cpu is put in a domain of its own at the
+	 * levels below the package and all cpus are put in the same package, so that the clients still get a (flat) topology.
+	 */
+	class topology{
+	public:
+		using size_type = unsigned int;
+
+		enum level{
+			core_level = 0,
+			l2_level,
+			l3_level,
+			package_level,
+			num_levels
+		};
+
+		struct cpu_info{
+			int domain[num_levels]; // the identifier of the domain of the cpu at each level
+		};
+
+		//! Reads the topology of the cpus 0,...,hardware_concurrency()-1 from sysfs.
+		topology();
+
+		//! Uses the given topology (cpus[i] is the information for cpu i). This is useful to lay out trees for a machine other than the current one.
+		explicit topology(std::vector<cpu_info> cpus);
+
+		size_type num_cpus() const{ return static_cast<size_type>(cpus.size()); }
+
+		//! The identifier of the domain of the given cpu at the given level
+		int domain(size_type cpu, level l) const{ return cpus[cpu].domain[l]; }
+
+	private:
+		std::vector<cpu_info> cpus;
+	};
+
+} // namespace internal
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef __TOURNAMENT_BARRIER_HPP_IS_INCLUDED__
+#define __TOURNAMENT_BARRIER_HPP_IS_INCLUDED__ 1
+
+#include <cassert>
+#include <vector>
+#include <atomic>
+#include "cache_line_size.hpp"
+#include "cache_aligned_alloc.hpp"
+
+namespace barrier{
+
+	/**
+	 * Tournament Barrier:
+	 * ------------------
+	 *
+	 * The threads play a tournament of ceil(log2 N) rounds where the winner of each match is statically assigned. In round r the thread with logical id i
+	 * such that i mod 2^(r+1) == 0 is the winner and waits for its opponent i + 2^r (if that thread exists, otherwise it gets a bye). The opponent is the
+	 * loser: it signals the winner's flag for round r and then spins on a flag in its own node until it is woken up. The thread 0 is the champion. When the
+	 * champion has won all its rounds every thread has arrived, and the champion releases everyone through a wakeup tree: each thread, once woken up,
+	 * wakes the opponents it has beaten starting from the last round (the one with the largest subtree).
+	 *
+	 * Each thread has the following data:
+	 *	(1) Where do my opponents signal me? One flag per round i have won (bye rounds excluded).
+	 *	(2) Where should i signal my arrival when i lose? std::atomic<bool>* arrival_parent (nullptr for the champion)
+	 *	(3) Where should my winner wake me up? std::atomic<bool> sense
+	 *	(4) Which opponents should i wake up? The senses of the threads i have beaten, in the reverse order of the rounds.
+	 *	(5) Which is my local sense? bool local_sense
+	 *
+	 * Unlike the static tree barrier no thread ever checks more than one arrival flag per round, so the critical path is one remote cache line transfer per
+	 * round. The flags use the local sense and thus never need to be re-set. A single set of flags is enough because a loser cannot signal its winner for the
+	 * next episode before it has been woken up, that is before the winner has consumed the signal of the current episode.
+	 *
+	 * Data Packing:
+	 * ------------
+	 * I pack the data of each thread in a node. The wiring of the nodes is fixed by the algorithm, so as in the dissemination barrier the barrier itself
+	 * allocates the nodes and the threads use the barrier through their logical id.
+	 *
+	 * Alignment Requirements:
+	 * ----------------------
+	 * Each node is allocated in its own cache-aligned storage. The sense of a node is written by its winner and the arrival flags by its opponents, thus
+	 * each one is padded to a cache line (same idea as the shared_flag of the static tree barrier).
+	 *
+	 * Usage:
+	 * -----
+	 *	Step (a): Construct the barrier instance with the number of threads:
+	 *		barrier::tournament_barrier barrier(num_threads);
+	 *	Step (b): Ensure memory visibility of the barrier instance to the threads (see centralized_sense_reversing_barrier).
+	 *	Step (c): Have the thread with logical id i (0 <= i < num_threads) use the barrier through await(i).
+	 */
+	class tournament_barrier{
+	public:
+		using size_type = unsigned int;
+
+		struct shared_flag{
+			std::atomic<bool> flag;
+			char _padding[CACHE_LINE_SIZE-sizeof(flag)];
+
+			shared_flag(){
+			 	flag = true;
+			}
+		};
+
+		// each node is allocated in cache-line boundaries
+		struct node{
+			// where my winner wakes me up
+			std::atomic<bool> sense;
+			char _sense_padding[CACHE_LINE_SIZE-sizeof(sense)];
+			// where my opponents signal me, one flag per round i have won
+			shared_flag* arrival_flags;
+			size_type num_arrival_flags;
+			// where should i signal my winner in the round i lose?
+			std::atomic<bool>* arrival_parent;
+			// which opponents must i wake up? (last round first)
+			std::atomic<bool>** wakeup_children;
+			size_type num_wakeup_children;
+			bool local_sense; // my local sense value
+		};
+
+		// Initialization is not atomic!
+		explicit tournament_barrier(size_type n) : num_threads{n}{
+			assert(n > 0);
+
+			// allocate the nodes and count the rounds each thread wins against a real opponent
+			for (size_type i = 0; i < num_threads; ++i){
+				node* nd = new (barrier::internal::cache_aligned_alloc(sizeof(node))) node();
+
+				nd->num_arrival_flags = 0;
+				for (unsigned long long stride = 1; stride < num_threads && i % (2*stride) == 0; stride *= 2){
+					if (i + stride < num_threads){
+						++nd->num_arrival_flags;
+					}
+				}
+
+				nd->sense = true;
+				nd->arrival_flags = static_cast<shared_flag*>(barrier::internal::cache_aligned_alloc(nd->num_arrival_flags*sizeof(shared_flag)));
+				for (size_type r = 0; r < nd->num_arrival_flags; ++r){
+					new (&nd->arrival_flags[r]) shared_flag();
+				}
+				nd->arrival_parent = nullptr;
+				nd->wakeup_children = new std::atomic<bool>*[nd->num_arrival_flags];
+				nd->num_wakeup_children = nd->num_arrival_flags;
+				nd->local_sense = false;
+
+				nodes.push_back(nd);
+			}
+
+			// play the tournament once to wire the winners with their opponents
+			for (size_type i = 0; i < num_threads; ++i){
+				size_type played = 0;
+
+				for (unsigned long long stride = 1; stride < num_threads && i % (2*stride) == 0; stride *= 2){
+					if (i + stride < num_threads){
+						node* loser = nodes[i + stride];
+
+						loser->arrival_parent = &nodes[i]->arrival_flags[played].flag;
+						// the opponent beaten last is woken up first
+						nodes[i]->wakeup_children[nodes[i]->num_wakeup_children - 1 - played] = &loser->sense;
+						++played;
+					}
+				}
+			}
+		}
+
+		tournament_barrier(const tournament_barrier&) = delete;
+		tournament_barrier& operator=(const tournament_barrier&) = delete;
+
+		~tournament_barrier(){
+			for (auto nd : nodes){
+				barrier::internal::cache_aligned_free(nd->arrival_flags);
+				delete [] nd->wakeup_children;
+				barrier::internal::cache_aligned_free(nd);
+			}
+		}
+
+		void await(size_type id){
+			// relaxed version
+			assert(id < num_threads);
+			node* n = nodes[id];
+
+			// win my rounds: exactly one flag per round
+			for (size_type r = 0; r < n->num_arrival_flags; ++r){
+				while (n->arrival_flags[r].flag.load(std::memory_order_relaxed) != n->local_sense){}
+				n->arrival_flags[r].flag.load(std::memory_order_acquire); // sync memory
+			}
+
+			// lose my match (unless i am the champion) and pass my winner the memory
+			if (n->arrival_parent){
+				n->arrival_parent->store(n->local_sense, std::memory_order_release);
+
+				// wait now until my winner wakes me up
+				while (n->sense.load(std::memory_order_relaxed) != n->local_sense){}
+				n->sense.load(std::memory_order_acquire); // sync memory
+			}
+
+			// wake up the opponents i have beaten
+			for (size_type c = 0; c < n->num_wakeup_children; ++c){
+				n->wakeup_children[c]->store(n->local_sense, std::memory_order_release); // also sync memory
+			}
+
+			n->local_sense = !n->local_sense;
+		}
+
+	private:
+		const size_type num_threads; // how many threads are expected to arrive at the barrier?
+		std::vector<node*> nodes; // nodes[i] is the node of the thread with logical id i
+	};
+
+} // namespace barrier
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef __TSC_HPP_IS_INCLUDED__
+#define __TSC_HPP_IS_INCLUDED__ 1
+
+#include <cstdint>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace barrier{
+
+namespace internal{
+
+	// A cheap timestamp for sampling the barriers: the time stamp counter on x86 (invariant and synchronized across the cores of the machines we run on),
+	// the steady clock elsewhere. The unit is whatever the source counts in, so only compare timestamps with each other.
+	inline std::uint64_t read_tsc(){
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+} // namespace internal
+
+} // namespace barrier
+
+#endif